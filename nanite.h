@@ -11,31 +11,53 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <stdbool.h>
 
-#define READER_BUFFSIZE 1024
-#define MAX_CONTENT_SIZE 1048576
+#if defined(__SSE__) || defined(_M_X64)
+  #include <xmmintrin.h>
+#endif
+
+#ifdef __linux__
+  #include <poll.h>
+  #include <fcntl.h>
+  #include <sys/uio.h>
+  #include <sys/stat.h>
+  #include <sys/inotify.h>
+  #include <sys/un.h>
+  #include <sys/time.h>
+  #include <sys/socket.h>
+#endif
+
+// Allocator entry points (defined in the memory section)
+void* memAlloc(size_t size);
+void memFree(void* pointer);
 
 /**
  * @brief File loading function.
  * 
  * @param filename The filename to load.
- * @return char* The file contents.
+ * @return char* The file contents (freed with memFree()).
  */
 char* readfile(const char* filename) {
-  FILE* file = fopen(filename, "r");
+  FILE* file = fopen(filename, "rb");
   if (!file)
     return NULL;
 
-  int flag = 0;
-  char* shader = (char*) malloc(MAX_CONTENT_SIZE);
-  char* buffer = (char*) malloc(READER_BUFFSIZE);
-  while (fgets(buffer, READER_BUFFSIZE, file) != NULL)
-    strcat(shader, buffer);
+  // Size the buffer to the file (plus the terminator)
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char* contents = length >= 0 ? (char*) memAlloc((size_t) length + 1) : NULL;
+  if (!contents || fread(contents, 1, (size_t) length, file) != (size_t) length) {
+    memFree(contents);
+    fclose(file);
+    return NULL;
+  }
 
-  free(buffer);
+  contents[length] = '\0';
   fclose(file);
-  return shader;
+  return contents;
 }
 
 /**
@@ -50,6 +72,622 @@ void error(char* msg) {
 
 #endif // MISCELLANEOUS_H
 
+#ifndef MEMORY_IMPLEMENTATION
+#define MEMORY_IMPLEMENTATION
+
+/**
+ * @brief The subsystems memory is accounted to
+ */
+typedef enum MEMORY_TAG {
+  MEMORY_ENTITIES,
+  MEMORY_SHADERS,
+  MEMORY_TILEMAPS,
+  MEMORY_PARTICLES,
+  MEMORY_TEXT,          // Fonts, strings and their laid-out glyphs
+  MEMORY_ASSETS,        // Images, packs and captured frames
+  MEMORY_QUEUES,        // Queues and hash maps
+  MEMORY_GL_BUFFERS,
+  MEMORY_GL_TEXTURES,
+  MEMORY_TAGS
+} MEMORY_TAG;
+
+/**
+ * @brief The memory counters of a subsystem (in bytes)
+ */
+typedef struct MemoryStats {
+  long long current;
+  long long peak;
+} MemoryStats;
+
+#define MEMORY_ALIGNMENT 16
+
+/**
+ * @brief The Allocator structure
+ *
+ * Every allocation nanite makes goes through these hooks. The alignment is a
+ * power of two, and is MEMORY_ALIGNMENT unless the memory came from
+ * memAlignedAlloc(); release() gets the same alignment the memory was
+ * allocated with, and reallocate() is only ever asked for MEMORY_ALIGNMENT.
+ */
+typedef struct Allocator {
+  void* (*allocate)(size_t size, size_t alignment, void* context);
+  void* (*reallocate)(void* pointer, size_t size, size_t alignment, void* context);
+  void (*release)(void* pointer, size_t alignment, void* context);
+  void* context;
+} Allocator;
+
+static const char* memoryNames[MEMORY_TAGS] = { "entities", "shaders", "tilemaps", "particles", "text", "assets", "queues", "gl buffers", "gl textures" };
+static MemoryStats memoryStats[MEMORY_TAGS];
+static SDL_SpinLock memoryLock;
+
+/**
+ * @brief The default allocation hook (the C library's allocator).
+ * 
+ * @param size The number of bytes
+ * @param alignment The alignment of the memory
+ * @param context Unused
+ * @return void* The memory, NULL on failure
+ */
+static void* defaultAllocate(size_t size, size_t alignment, void* context) {
+  (void) context;
+  if (alignment <= MEMORY_ALIGNMENT)
+    return malloc(size);
+
+  #ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+  #else
+    void* pointer = NULL;
+    return posix_memalign(&pointer, alignment, size) == 0 ? pointer : NULL;
+  #endif
+}
+
+/**
+ * @brief The default reallocation hook (the C library's allocator).
+ * 
+ * @param pointer The memory to resize
+ * @param size The new number of bytes
+ * @param alignment The alignment of the memory (always MEMORY_ALIGNMENT)
+ * @param context Unused
+ * @return void* The resized memory, NULL on failure
+ */
+static void* defaultReallocate(void* pointer, size_t size, size_t alignment, void* context) {
+  (void) alignment;
+  (void) context;
+  return realloc(pointer, size);
+}
+
+/**
+ * @brief The default release hook (the C library's allocator).
+ * 
+ * @param pointer The memory to free
+ * @param alignment The alignment the memory was allocated with
+ * @param context Unused
+ */
+static void defaultRelease(void* pointer, size_t alignment, void* context) {
+  (void) context;
+  #ifdef _WIN32
+    if (alignment > MEMORY_ALIGNMENT) {
+      _aligned_free(pointer);
+      return;
+    }
+  #endif
+  (void) alignment;
+  free(pointer);
+}
+
+static Allocator allocator = { defaultAllocate, defaultReallocate, defaultRelease, NULL };
+
+/**
+ * @brief Routes every allocation nanite makes through a custom allocator.
+ * 
+ * Set it before creating anything; memory must be freed by the allocator that allocated it.
+ * 
+ * @param hooks The allocator (NULL restores the C library's allocator)
+ */
+void setAllocator(const Allocator* hooks) {
+  if (hooks && hooks -> allocate && hooks -> reallocate && hooks -> release)
+    allocator = *hooks;
+  else
+    allocator = (Allocator) { defaultAllocate, defaultReallocate, defaultRelease, NULL };
+}
+
+/**
+ * @brief Allocates memory through the allocator.
+ * 
+ * @param size The number of bytes
+ * @return void* The memory, NULL on failure
+ */
+void* memAlloc(size_t size) {
+  return allocator.allocate(size ? size : 1, MEMORY_ALIGNMENT, allocator.context);
+}
+
+/**
+ * @brief Allocates zeroed memory through the allocator.
+ * 
+ * @param count The number of elements
+ * @param size The size of an element
+ * @return void* The memory, NULL on failure
+ */
+void* memCalloc(size_t count, size_t size) {
+  // Refuse sizes that overflow
+  if (size && count > (size_t) -1 / size)
+    return NULL;
+
+  void* pointer = memAlloc(count * size);
+  if (pointer)
+    memset(pointer, 0, count * size);
+  return pointer;
+}
+
+/**
+ * @brief Resizes memory through the allocator.
+ * 
+ * @param pointer The memory to resize (NULL to allocate)
+ * @param size The new number of bytes
+ * @return void* The resized memory, NULL on failure (the old memory is untouched)
+ */
+void* memRealloc(void* pointer, size_t size) {
+  if (!pointer)
+    return memAlloc(size);
+  return allocator.reallocate(pointer, size ? size : 1, MEMORY_ALIGNMENT, allocator.context);
+}
+
+/**
+ * @brief Frees memory through the allocator.
+ * 
+ * @param pointer The memory (NULL is ignored)
+ */
+void memFree(void* pointer) {
+  if (pointer)
+    allocator.release(pointer, MEMORY_ALIGNMENT, allocator.context);
+}
+
+/**
+ * @brief Allocates over-aligned memory (e.g. for SIMD data) through the allocator.
+ * 
+ * @param size The number of bytes
+ * @param alignment The alignment (a power of two)
+ * @return void* The memory, NULL on failure
+ */
+void* memAlignedAlloc(size_t size, size_t alignment) {
+  if (alignment < MEMORY_ALIGNMENT)
+    alignment = MEMORY_ALIGNMENT;
+  if (alignment & (alignment - 1))
+    return NULL;
+  return allocator.allocate(size ? size : 1, alignment, allocator.context);
+}
+
+/**
+ * @brief Frees memory from memAlignedAlloc().
+ * 
+ * @param pointer The memory (NULL is ignored)
+ * @param alignment The alignment it was allocated with
+ */
+void memAlignedFree(void* pointer, size_t alignment) {
+  if (alignment < MEMORY_ALIGNMENT)
+    alignment = MEMORY_ALIGNMENT;
+  if (pointer)
+    allocator.release(pointer, alignment, allocator.context);
+}
+
+/**
+ * @brief Duplicates a string through the allocator.
+ * 
+ * @param string The string
+ * @return char* The copy, NULL on failure
+ */
+char* memStrdup(const char* string) {
+  size_t length = strlen(string) + 1;
+  char* copy = (char*) memAlloc(length);
+  if (copy)
+    memcpy(copy, string, length);
+  return copy;
+}
+
+/**
+ * @brief Accounts an allocation (or a release) to a subsystem.
+ * 
+ * @param tag The subsystem
+ * @param bytes The number of bytes allocated (negative when released)
+ */
+void trackMemory(MEMORY_TAG tag, long long bytes) {
+  SDL_AtomicLock(&memoryLock);
+  memoryStats[tag].current += bytes;
+  if (memoryStats[tag].current > memoryStats[tag].peak)
+    memoryStats[tag].peak = memoryStats[tag].current;
+  SDL_AtomicUnlock(&memoryLock);
+}
+
+/**
+ * @brief Gets the memory counters of a subsystem.
+ * 
+ * @param tag The subsystem (MEMORY_TAGS for the sum of every subsystem)
+ * @return MemoryStats The current and peak byte counts
+ */
+MemoryStats getMemoryStats(MEMORY_TAG tag) {
+  MemoryStats stats = { 0, 0 };
+  SDL_AtomicLock(&memoryLock);
+  if (tag < MEMORY_TAGS)
+    stats = memoryStats[tag];
+  else {
+    register unsigned int itr;
+    for (itr = 0; itr < MEMORY_TAGS; itr++) {
+      stats.current += memoryStats[itr].current;
+      stats.peak += memoryStats[itr].peak;
+    }
+  }
+  SDL_AtomicUnlock(&memoryLock);
+  return stats;
+}
+
+/**
+ * @brief Prints the memory counters of every subsystem.
+ * 
+ * @param stream The stream to print to (stdout if NULL)
+ */
+void dumpMemory(FILE* stream) {
+  if (!stream)
+    stream = stdout;
+
+  fprintf(stream, "%-12s %14s %14s\n", "memory", "current", "peak");
+  register unsigned int itr;
+  for (itr = 0; itr < MEMORY_TAGS; itr++) {
+    MemoryStats stats = getMemoryStats((MEMORY_TAG) itr);
+    fprintf(stream, "%-12s %14lld %14lld\n", memoryNames[itr], stats.current, stats.peak);
+  }
+  MemoryStats total = getMemoryStats(MEMORY_TAGS);
+  fprintf(stream, "%-12s %14lld %14lld\n", "total", total.current, total.peak);
+}
+
+#endif // MEMORY_IMPLEMENTATION
+
+#ifndef METRICS_IMPLEMENTATION
+#define METRICS_IMPLEMENTATION
+
+#define METRICS_BUCKETS 10        // Frame time histogram buckets (the last is unbounded)
+#define METRICS_BUFFER 16384      // The largest export (bytes)
+#define METRICS_INTERVAL 5000     // The export interval run() uses (ms)
+
+/**
+ * @brief The metrics export formats
+ */
+typedef enum METRICS_FORMAT {
+  METRICS_PROMETHEUS,   // Prometheus text exposition (the file is replaced on every export)
+  METRICS_JSON          // One JSON object per export (appended as a line)
+} METRICS_FORMAT;
+
+/**
+ * @brief The kinds of asset whose load times are measured
+ */
+typedef enum METRICS_LOAD {
+  LOAD_IMAGE,
+  LOAD_PACK,
+  LOAD_SHADER,
+  LOAD_SCENE,
+  LOAD_FONT,
+  LOAD_KINDS
+} METRICS_LOAD;
+
+/**
+ * @brief The Metrics structure (totals since metrics started)
+ */
+typedef struct Metrics {
+  unsigned long long frames;
+  unsigned long long buckets[METRICS_BUCKETS];  // Frames per frame time bucket
+  double frameTime;                             // The sum of every frame time (ms)
+  float worstFrame;                             // The longest frame since the last export (ms)
+  unsigned long long drawCalls, uploads, uploadBytes, entities;
+  unsigned long long loads[LOAD_KINDS];
+  double loadTime[LOAD_KINDS];                  // The sum of the load times (ms)
+} Metrics;
+
+static const double metricsBounds[METRICS_BUCKETS - 1] = { 1, 2, 4, 8, 16, 33, 50, 100, 250 };
+static const char* loadNames[LOAD_KINDS] = { "image", "pack", "shader", "scene", "font" };
+static Metrics metrics;
+static SDL_SpinLock metricsLock;        // Guards the totals (frames and loads are recorded on several threads)
+static SDL_atomic_t metricsRunning;     // Whether metrics are being recorded
+static SDL_Thread* metricsThread;       // The thread writing the exports
+static SDL_sem* metricsStop;            // Posted to stop the export thread
+static char* metricsPath;               // The file, or "unix:" and a socket path
+static METRICS_FORMAT metricsFormat;
+static unsigned int metricsInterval;    // The time between exports (ms)
+static Uint64 metricsStart;             // When metrics started (performance counter)
+static Uint64 metricsFrame;             // When the last frame was recorded
+
+/**
+ * @brief Records a drawn frame (the frame time is the time since the last one).
+ * 
+ * @param drawCalls The frame's draw calls
+ * @param uploads The frame's uploads
+ * @param uploadBytes The frame's uploaded bytes
+ * @param entities The frame's entities drawn
+ */
+void recordFrameMetrics(unsigned int drawCalls, unsigned int uploads, unsigned long long uploadBytes, unsigned int entities) {
+  if (!SDL_AtomicGet(&metricsRunning))
+    return;
+
+  // Time the frame, skipping the first one (it has no predecessor)
+  Uint64 now = SDL_GetPerformanceCounter();
+  double time = metricsFrame ? (now - metricsFrame) * 1000.0 / SDL_GetPerformanceFrequency() : -1.0;
+  metricsFrame = now;
+
+  SDL_AtomicLock(&metricsLock);
+  if (time >= 0.0) {
+    register unsigned int bucket = 0;
+    while (bucket < METRICS_BUCKETS - 1 && time > metricsBounds[bucket])
+      bucket++;
+    metrics.buckets[bucket]++;
+    metrics.frames++;
+    metrics.frameTime += time;
+    if (time > metrics.worstFrame)
+      metrics.worstFrame = (float) time;
+  }
+  metrics.drawCalls += drawCalls;
+  metrics.uploads += uploads;
+  metrics.uploadBytes += uploadBytes;
+  metrics.entities += entities;
+  SDL_AtomicUnlock(&metricsLock);
+}
+
+/**
+ * @brief Skips timing the next frame (the time since the last one wasn't spent drawing).
+ */
+void skipFrameMetrics(void) {
+  metricsFrame = 0;
+}
+
+/**
+ * @brief Records an asset load.
+ * 
+ * @param kind The kind of asset
+ * @param start When the load started (performance counter)
+ */
+void recordLoadMetrics(METRICS_LOAD kind, Uint64 start) {
+  if (!SDL_AtomicGet(&metricsRunning) || kind >= LOAD_KINDS)
+    return;
+
+  double time = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+  SDL_AtomicLock(&metricsLock);
+  metrics.loads[kind]++;
+  metrics.loadTime[kind] += time;
+  SDL_AtomicUnlock(&metricsLock);
+}
+
+/**
+ * @brief Appends formatted text to an export.
+ * 
+ * @param buffer The export (METRICS_BUFFER bytes)
+ * @param length The length of the export so far
+ * @param format The format string
+ * @return The new length (clamped to the buffer)
+ */
+static int appendMetrics(char* buffer, int length, const char* format, ...) {
+  va_list arguments;
+  va_start(arguments, format);
+  int written = vsnprintf(buffer + length, METRICS_BUFFER - length, format, arguments);
+  va_end(arguments);
+  if (written < 0)
+    return length;
+  return length + written < METRICS_BUFFER ? length + written : METRICS_BUFFER - 1;
+}
+
+/**
+ * @brief Formats a snapshot of the metrics.
+ * 
+ * @param buffer The export (METRICS_BUFFER bytes)
+ * @param snapshot The totals
+ * @return The length of the export
+ */
+static int formatMetrics(char* buffer, const Metrics* snapshot) {
+  double uptime = (SDL_GetPerformanceCounter() - metricsStart) / (double) SDL_GetPerformanceFrequency();
+  register unsigned int itr;
+  int length = 0;
+
+  if (metricsFormat == METRICS_PROMETHEUS) {
+    // Frame times as a cumulative histogram (Prometheus times are in seconds)
+    length = appendMetrics(buffer, length, "# TYPE nanite_frame_time_seconds histogram\n");
+    unsigned long long cumulative = 0;
+    for (itr = 0; itr < METRICS_BUCKETS; itr++) {
+      cumulative += snapshot -> buckets[itr];
+      if (itr < METRICS_BUCKETS - 1)
+        length = appendMetrics(buffer, length, "nanite_frame_time_seconds_bucket{le=\"%g\"} %llu\n", metricsBounds[itr] / 1000.0, cumulative);
+      else
+        length = appendMetrics(buffer, length, "nanite_frame_time_seconds_bucket{le=\"+Inf\"} %llu\n", cumulative);
+    }
+    length = appendMetrics(buffer, length, "nanite_frame_time_seconds_sum %.6f\nnanite_frame_time_seconds_count %llu\n", snapshot -> frameTime / 1000.0, snapshot -> frames);
+    length = appendMetrics(buffer, length, "# TYPE nanite_worst_frame_seconds gauge\nnanite_worst_frame_seconds %.6f\n", snapshot -> worstFrame / 1000.0);
+
+    // Render counters
+    length = appendMetrics(buffer, length, "# TYPE nanite_draw_calls_total counter\nnanite_draw_calls_total %llu\n", snapshot -> drawCalls);
+    length = appendMetrics(buffer, length, "# TYPE nanite_uploads_total counter\nnanite_uploads_total %llu\n", snapshot -> uploads);
+    length = appendMetrics(buffer, length, "# TYPE nanite_upload_bytes_total counter\nnanite_upload_bytes_total %llu\n", snapshot -> uploadBytes);
+    length = appendMetrics(buffer, length, "# TYPE nanite_entities_drawn_total counter\nnanite_entities_drawn_total %llu\n", snapshot -> entities);
+
+    // Asset load times
+    length = appendMetrics(buffer, length, "# TYPE nanite_load_time_seconds summary\n");
+    for (itr = 0; itr < LOAD_KINDS; itr++) {
+      length = appendMetrics(buffer, length, "nanite_load_time_seconds_sum{kind=\"%s\"} %.6f\n", loadNames[itr], snapshot -> loadTime[itr] / 1000.0);
+      length = appendMetrics(buffer, length, "nanite_load_time_seconds_count{kind=\"%s\"} %llu\n", loadNames[itr], snapshot -> loads[itr]);
+    }
+
+    // Memory counters
+    length = appendMetrics(buffer, length, "# TYPE nanite_memory_bytes gauge\n");
+    for (itr = 0; itr < MEMORY_TAGS; itr++)
+      length = appendMetrics(buffer, length, "nanite_memory_bytes{tag=\"%s\"} %lld\n", memoryNames[itr], getMemoryStats((MEMORY_TAG) itr).current);
+    length = appendMetrics(buffer, length, "# TYPE nanite_memory_peak_bytes gauge\n");
+    for (itr = 0; itr < MEMORY_TAGS; itr++)
+      length = appendMetrics(buffer, length, "nanite_memory_peak_bytes{tag=\"%s\"} %lld\n", memoryNames[itr], getMemoryStats((MEMORY_TAG) itr).peak);
+    length = appendMetrics(buffer, length, "# TYPE nanite_uptime_seconds gauge\nnanite_uptime_seconds %.3f\n", uptime);
+    return length;
+  }
+
+  // A JSON object on a single line (with a wall clock time where there is one)
+  length = appendMetrics(buffer, length, "{");
+  #ifdef __linux__
+    struct timeval clock;
+    gettimeofday(&clock, NULL);
+    length = appendMetrics(buffer, length, "\"time\":%.3f,", clock.tv_sec + clock.tv_usec / 1e6);
+  #endif
+  length = appendMetrics(buffer, length, "\"uptime\":%.3f,\"frames\":%llu,\"frame_time_ms\":%.3f,\"worst_frame_ms\":%.3f,\"frame_buckets\":[",
+    uptime, snapshot -> frames, snapshot -> frameTime, snapshot -> worstFrame);
+  for (itr = 0; itr < METRICS_BUCKETS; itr++)
+    length = appendMetrics(buffer, length, itr ? ",%llu" : "%llu", snapshot -> buckets[itr]);
+  length = appendMetrics(buffer, length, "],\"draw_calls\":%llu,\"uploads\":%llu,\"upload_bytes\":%llu,\"entities\":%llu,\"loads\":{",
+    snapshot -> drawCalls, snapshot -> uploads, snapshot -> uploadBytes, snapshot -> entities);
+  for (itr = 0; itr < LOAD_KINDS; itr++)
+    length = appendMetrics(buffer, length, "%s\"%s\":{\"count\":%llu,\"ms\":%.3f}", itr ? "," : "", loadNames[itr], snapshot -> loads[itr], snapshot -> loadTime[itr]);
+  length = appendMetrics(buffer, length, "},\"memory\":{");
+  for (itr = 0; itr < MEMORY_TAGS; itr++) {
+    MemoryStats stats = getMemoryStats((MEMORY_TAG) itr);
+    length = appendMetrics(buffer, length, "%s\"%s\":{\"current\":%lld,\"peak\":%lld}", itr ? "," : "", memoryNames[itr], stats.current, stats.peak);
+  }
+  return appendMetrics(buffer, length, "}}\n");
+}
+
+/**
+ * @brief Writes an export to the metrics file or socket.
+ * 
+ * @param buffer The export
+ * @param length The length of the export
+ */
+static void writeMetrics(const char* buffer, int length) {
+  #ifdef __linux__
+    // Send to a listening socket without blocking, dropping the export if nobody's there (or they're slow)
+    if (strncmp(metricsPath, "unix:", 5) == 0) {
+      struct sockaddr_un address = { .sun_family = AF_UNIX };
+      strncpy(address.sun_path, metricsPath + 5, sizeof(address.sun_path) - 1);
+      int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+      if (fd < 0)
+        return;
+
+      // Own the socket through a stream, as the window's close() shadows the descriptor one
+      FILE* stream = fdopen(fd, "w");
+      if (!stream) {
+        shutdown(fd, SHUT_RDWR);
+        return;
+      }
+      if (connect(fd, (struct sockaddr*) &address, sizeof(address)) == 0)
+        send(fd, buffer, (size_t) length, MSG_NOSIGNAL);
+      fclose(stream);
+      return;
+    }
+  #endif
+
+  // Append JSON lines
+  if (metricsFormat == METRICS_JSON) {
+    FILE* file = fopen(metricsPath, "a");
+    if (!file)
+      return;
+    fwrite(buffer, 1, (size_t) length, file);
+    fclose(file);
+    return;
+  }
+
+  // Replace the Prometheus file in one step, so readers never see half of it
+  size_t size = strlen(metricsPath) + 5;
+  char* temporary = (char*) memAlloc(size);
+  if (!temporary)
+    return;
+  snprintf(temporary, size, "%s.tmp", metricsPath);
+  FILE* file = fopen(temporary, "w");
+  if (file) {
+    fwrite(buffer, 1, (size_t) length, file);
+    bool written = !ferror(file);
+    fclose(file);
+    if (written)
+      rename(temporary, metricsPath);
+  }
+  memFree(temporary);
+}
+
+/**
+ * @brief Snapshots and writes the metrics.
+ */
+static void exportMetrics(void) {
+  static char buffer[METRICS_BUFFER];
+
+  // Copy the totals, starting a new worst frame
+  SDL_AtomicLock(&metricsLock);
+  Metrics snapshot = metrics;
+  metrics.worstFrame = 0.0f;
+  SDL_AtomicUnlock(&metricsLock);
+
+  writeMetrics(buffer, formatMetrics(buffer, &snapshot));
+}
+
+/**
+ * @brief Exports the metrics every interval until stopped (export thread).
+ * 
+ * @param data Unused
+ * @return 0 when the thread stops
+ */
+static int exportMetricsLoop(void* data) {
+  (void) data;
+  SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+  while (SDL_SemWaitTimeout(metricsStop, metricsInterval) == SDL_MUTEX_TIMEDOUT)
+    exportMetrics();
+
+  // Write the final totals
+  exportMetrics();
+  return 0;
+}
+
+/**
+ * @brief Starts recording metrics and exporting them from a low-priority thread.
+ * 
+ * @param path The file to write, or "unix:" followed by the path of a listening socket
+ * @param format The export format
+ * @param interval The time between exports (ms)
+ * @return true if metrics started
+ */
+bool startMetrics(const char* path, METRICS_FORMAT format, unsigned int interval) {
+  // Verify the path, and that metrics aren't already running
+  if (!path || metricsThread)
+    return false;
+
+  // Start from zero
+  memset(&metrics, 0, sizeof(metrics));
+  metricsPath = memStrdup(path);
+  metricsFormat = format;
+  metricsInterval = interval ? interval : METRICS_INTERVAL;
+  metricsStart = SDL_GetPerformanceCounter();
+  metricsFrame = 0;
+
+  // Start the export thread
+  metricsStop = SDL_CreateSemaphore(0);
+  SDL_AtomicSet(&metricsRunning, 1);
+  metricsThread = SDL_CreateThread(exportMetricsLoop, "nanite-metrics", NULL);
+  if (!metricsThread) {
+    fprintf(stderr, "Error: Could not start the metrics thread.\n");
+    SDL_AtomicSet(&metricsRunning, 0);
+    SDL_DestroySemaphore(metricsStop);
+    memFree(metricsPath);
+    metricsPath = NULL;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Stops recording metrics, writing a final export.
+ */
+void stopMetrics(void) {
+  if (!metricsThread)
+    return;
+
+  SDL_AtomicSet(&metricsRunning, 0);
+  SDL_SemPost(metricsStop);
+  SDL_WaitThread(metricsThread, NULL);
+  SDL_DestroySemaphore(metricsStop);
+  memFree(metricsPath);
+  metricsThread = NULL;
+  metricsStop = NULL;
+  metricsPath = NULL;
+}
+
+#endif // METRICS_IMPLEMENTATION
+
 #ifndef BMP_IMPLEMENTATION
 #define BMP_IMPLEMENTATION
 
@@ -82,6 +720,20 @@ typedef struct BMP {
   unsigned char* data;  // (4 * WIDTH * HEIGHT) bytes
 } BMP;
 
+/**
+ * @brief Reads a little-endian integer from a byte buffer.
+ * 
+ * @param buffer The buffer to read from.
+ * @param bytes The number of bytes to read.
+ * @return unsigned long int The value.
+ */
+static unsigned long int unpackBMP(const unsigned char* buffer, int bytes) {
+  unsigned long int value = 0;
+  for (int itr = 0; itr < bytes; itr++)
+    value |= (unsigned long int) buffer[itr] << (8 * itr);
+  return value;
+}
+
 /**
  * @brief Loads a BMP file into a BMP structure.
  * 
@@ -89,6 +741,8 @@ typedef struct BMP {
  * @return BMP* The BMP structure.
  */
 BMP* loadBMP(const char* filename) {
+  Uint64 start = SDL_GetPerformanceCounter();
+
   // Verify the filename
   if (filename == NULL) {
     fprintf(stderr, "Error: Invalid filename.\n");
@@ -102,35 +756,61 @@ BMP* loadBMP(const char* filename) {
     return NULL;
   }
 
-  // Allocate memory for the BMP structure.
-  BMP* img = (BMP*) malloc(sizeof(BMP));
-  if (!img) {
-    fprintf(stderr, "Error: Could not allocate memory.\n");
-    return NULL;
-  }
-
-  // Read the header into a buffer and verify the signature.
-  unsigned char buffer[sizeof(HEADER)];
-  if (fgets(buffer, sizeof(HEADER), file) == NULL) {
+  // Read the 54-byte header into a buffer.
+  unsigned char buffer[54];
+  if (fread(buffer, sizeof(buffer), 1, file) != 1) {
     fprintf(stderr, "Error: Could not read file.\n");
+    fclose(file);
     return NULL;
   }
 
   // Verify the signature.
   if (buffer[0] != 'B' || buffer[1] != 'M') {
     fprintf(stderr, "Error: Invalid signature.\n");
+    fclose(file);
+    return NULL;
+  }
+
+  // Allocate memory for the BMP structure.
+  BMP* img = (BMP*) memAlloc(sizeof(BMP));
+  if (!img) {
+    fprintf(stderr, "Error: Could not allocate memory.\n");
+    fclose(file);
     return NULL;
   }
 
-  // Copy the header into the BMP structure.
-  memcpy(&(img -> header), buffer, sizeof(HEADER));
+  // Unpack the header into the BMP structure (HEADER itself is padded).
+  img -> header.signature = unpackBMP(buffer, 2);
+  img -> header.filesize = unpackBMP(buffer + 2, 4);
+  img -> header.reserved = unpackBMP(buffer + 6, 4);
+  img -> header.dataoffset = unpackBMP(buffer + 10, 4);
+  img -> header.headersize = unpackBMP(buffer + 14, 4);
+  img -> header.width = unpackBMP(buffer + 18, 4);
+  img -> header.height = unpackBMP(buffer + 22, 4);
+  img -> header.planes = unpackBMP(buffer + 26, 2);
+  img -> header.bitsperpixel = unpackBMP(buffer + 28, 2);
+  img -> header.compression = unpackBMP(buffer + 30, 4);
+  img -> header.imagesize = unpackBMP(buffer + 34, 4);
+  img -> header.xresolution = unpackBMP(buffer + 38, 4);
+  img -> header.yresolution = unpackBMP(buffer + 42, 4);
+  img -> header.numcolors = unpackBMP(buffer + 46, 4);
+  img -> header.importantcolors = unpackBMP(buffer + 50, 4);
+
+  // Uncompressed bitmaps may leave the image size as 0.
+  if (img -> header.imagesize == 0) {
+    unsigned long int stride = ((img -> header.width) * (img -> header.bitsperpixel) + 31) / 32 * 4;
+    img -> header.imagesize = stride * abs((int32_t) img -> header.height);
+  }
 
   // Allocate memory for the image data.
-  img -> data = (unsigned char*) malloc(img -> header.imagesize);
+  img -> data = (unsigned char*) memAlloc(img -> header.imagesize);
 
   // Read the image data into the buffer.
-  if (fgets(img -> data, img -> header.imagesize, file) == NULL) {
+  if (!(img -> data) || fseek(file, img -> header.dataoffset, SEEK_SET) != 0 || fread(img -> data, img -> header.imagesize, 1, file) != 1) {
     fprintf(stderr, "Error: Could not read file.\n");
+    memFree(img -> data);
+    memFree(img);
+    fclose(file);
     return NULL;
   }
 
@@ -138,9 +818,73 @@ BMP* loadBMP(const char* filename) {
   fclose(file);
 
   // Return the BMP structure.
+  trackMemory(MEMORY_ASSETS, sizeof(BMP) + img -> header.imagesize);
+  recordLoadMetrics(LOAD_IMAGE, start);
   return img;
 }
 
+/**
+ * @brief Decodes the pixels of a BMP structure into RGBA.
+ * 
+ * @param img The BMP structure (24 or 32 bits per pixel, uncompressed).
+ * @return unsigned char* The bottom-up RGBA rows (4 * WIDTH * HEIGHT bytes, freed with memFree()), NULL if unsupported.
+ */
+unsigned char* decodeBMP(BMP* img) {
+  // Verify that the format is supported.
+  if (!img || (img -> header.bitsperpixel != 24 && img -> header.bitsperpixel != 32) || (img -> header.compression != 0 && img -> header.compression != 3)) {
+    fprintf(stderr, "Error: Unsupported BMP format.\n");
+    return NULL;
+  }
+
+  // Verify that the rows fit in the image data that was read.
+  int32_t width = (int32_t) img -> header.width, signedHeight = (int32_t) img -> header.height;
+  if (width <= 0 || signedHeight == 0 || signedHeight == INT32_MIN) {
+    fprintf(stderr, "Error: Invalid BMP dimensions.\n");
+    return NULL;
+  }
+  int height = abs(signedHeight);
+  bool topdown = signedHeight < 0;
+  int bytes = img -> header.bitsperpixel / 8;
+  unsigned long int stride = ((unsigned long int) width * (img -> header.bitsperpixel) + 31) / 32 * 4;
+  if (stride * (unsigned long int) height > img -> header.imagesize) {
+    fprintf(stderr, "Error: BMP pixel data is truncated.\n");
+    return NULL;
+  }
+
+  // Allocate memory for the pixels.
+  unsigned char* pixels = (unsigned char*) memAlloc((size_t) width * height * 4);
+  if (!pixels)
+    return NULL;
+
+  // Swizzle BGR(A) into RGBA, flipping top-down bitmaps.
+  for (int row = 0; row < height; row++) {
+    const unsigned char* src = img -> data + stride * (topdown ? height - 1 - row : row);
+    unsigned char* dst = pixels + (size_t) row * width * 4;
+    for (int col = 0; col < width; col++, src += bytes, dst += 4) {
+      dst[0] = src[2];
+      dst[1] = src[1];
+      dst[2] = src[0];
+      dst[3] = bytes == 4 ? src[3] : 255;
+    }
+  }
+
+  return pixels;
+}
+
+/**
+ * @brief Writes a little-endian integer into a byte buffer.
+ * 
+ * @param buffer The buffer to write into.
+ * @param value The value to write.
+ * @param bytes The number of bytes to write.
+ * @return unsigned char* The position after the written bytes.
+ */
+static unsigned char* packBMP(unsigned char* buffer, unsigned long int value, int bytes) {
+  for (int itr = 0; itr < bytes; itr++)
+    *buffer++ = (unsigned char) (value >> (8 * itr));
+  return buffer;
+}
+
 /**
  * @brief Saves a BMP structure into a BMP file.
  * 
@@ -162,15 +906,35 @@ int saveBMP(const char* filename, BMP* bmp) {
     return 1;
   }
 
+  // Pack the header into its 54-byte on-disk layout (HEADER itself is padded).
+  unsigned char buffer[54], *itr = buffer;
+  itr = packBMP(itr, bmp -> header.signature, 2);
+  itr = packBMP(itr, bmp -> header.filesize, 4);
+  itr = packBMP(itr, bmp -> header.reserved, 4);
+  itr = packBMP(itr, bmp -> header.dataoffset, 4);
+  itr = packBMP(itr, bmp -> header.headersize, 4);
+  itr = packBMP(itr, bmp -> header.width, 4);
+  itr = packBMP(itr, bmp -> header.height, 4);
+  itr = packBMP(itr, bmp -> header.planes, 2);
+  itr = packBMP(itr, bmp -> header.bitsperpixel, 2);
+  itr = packBMP(itr, bmp -> header.compression, 4);
+  itr = packBMP(itr, bmp -> header.imagesize, 4);
+  itr = packBMP(itr, bmp -> header.xresolution, 4);
+  itr = packBMP(itr, bmp -> header.yresolution, 4);
+  itr = packBMP(itr, bmp -> header.numcolors, 4);
+  itr = packBMP(itr, bmp -> header.importantcolors, 4);
+
   // Write the header to the file.
-  if (fwrite(&(bmp -> header), sizeof(HEADER), 1, file) != 1) {
+  if (fwrite(buffer, sizeof(buffer), 1, file) != 1) {
     fprintf(stderr, "Error: Could not write to file.\n");
+    fclose(file);
     return 1;
   }
 
   // Write the image data to the file.
   if (fwrite(bmp -> data, bmp -> header.imagesize, 1, file) != 1) {
     fprintf(stderr, "Error: Could not write to file.\n");
+    fclose(file);
     return 1;
   }
 
@@ -194,10 +958,11 @@ void freeBMP(BMP* img) {
   }
 
   // Free the image data.
-  free(img -> data);
+  trackMemory(MEMORY_ASSETS, -(long long) (sizeof(BMP) + img -> header.imagesize));
+  memFree(img -> data);
 
   // Free the BMP structure.
-  free(img);
+  memFree(img);
 }
 
 #endif // BMP_IMPLEMENTATION
@@ -205,16 +970,29 @@ void freeBMP(BMP* img) {
 #ifndef QUEUE_IMPLEMENTATION
 #define QUEUE_IMPLEMENTATION
 
-#define QUEUE_MAX 2048
+#define QUEUE_CAPACITY 64
 
 /**
  * @brief The queue structure
+ *
+ * A circular buffer whose capacity is always a power of two, so positions
+ * wrap with a mask instead of a modulo. The front and rear counters run
+ * freely and their difference is the number of queued elements.
  */
 typedef struct Queue {
   void** elements;
   unsigned int front, rear;
+  unsigned int capacity;
 } Queue;
 
+/**
+ * @brief The queue iterator structure
+ */
+typedef struct QueueIterator {
+  Queue* queue;
+  unsigned int index;
+} QueueIterator;
+
 /**
  * @brief Create an empty queue
  * 
@@ -222,13 +1000,21 @@ typedef struct Queue {
  */
 Queue* createQueue(void) {
   // Create a queue pointer
-  Queue* queue = (Queue*) malloc(sizeof(Queue));
+  Queue* queue = (Queue*) memAlloc(sizeof(Queue));
+  if (!queue)
+    return NULL;
 
-  // Set the queue's front and rear to equal -1
-  queue -> front = queue -> rear = -1;
+  // Set the queue's front and rear to equal 0
+  queue -> front = queue -> rear = 0;
 
-  // Set every element in the queue to NULL
-  queue -> elements = (void*) malloc(sizeof(void*) * QUEUE_MAX);
+  // Allocate the initial ring of elements
+  queue -> capacity = QUEUE_CAPACITY;
+  queue -> elements = (void**) memAlloc(sizeof(void*) * QUEUE_CAPACITY);
+  if (!(queue -> elements)) {
+    memFree(queue);
+    return NULL;
+  }
+  trackMemory(MEMORY_QUEUES, sizeof(Queue) + sizeof(void*) * QUEUE_CAPACITY);
 
   // Return the empty queue
   return queue;
@@ -245,27 +1031,27 @@ bool isEmpty(Queue* queue) {
   if (!queue)
     return true;
 
-  // Returns whether the index of front of the queue is -1
-  return queue -> front == -1;
+  // Returns whether the front of the queue has caught up with the rear
+  return queue -> front == queue -> rear;
 }
 
 /**
  * @brief Checks if a queue is full
  * 
  * @param queue The pointer to a queue structure
- * @return true if the queue is full
+ * @return true if the queue is full (the next enqueue grows it)
  */
 bool isFull(Queue* queue) {
   // Verify that the queue exists
   if (!queue)
     return true;
 
-  // Returns whether the index of back of the queue is greater equal to (QUEUE_MAX - 1)
-  return queue -> rear == (QUEUE_MAX - 1);
+  // Returns whether every slot of the ring is occupied
+  return (queue -> rear - queue -> front) == queue -> capacity;
 }
 
 /**
- * @brief Get the capacity of the queue
+ * @brief Get the number of elements in the queue
  * 
  * @param queue The pointer to a queue structure
  * @return The size of the queue
@@ -273,15 +1059,42 @@ bool isFull(Queue* queue) {
 unsigned int queueSize(Queue* queue) {
   // Verify that the queue exists
   if (!queue)
-    return true;
+    return 0;
 
-  // Return the size of the queue
-  if (isEmpty(queue))           
-    return 0;                     // Return 0 if the queue is empty
-  else if (isFull)
-    return QUEUE_MAX;             // Return QUEUE_MAX if the queue is full
-  else
-    return (queue -> rear) + 1;   // Return the difference between front and rear index + 1
+  // Return the difference between the rear and front counters
+  return queue -> rear - queue -> front;
+}
+
+/**
+ * @brief Doubles the capacity of a queue, unwrapping its elements
+ * 
+ * @param queue The pointer to a queue structure
+ * @return true if successful
+ */
+static bool growQueue(Queue* queue) {
+  // Allocate a ring twice the size of the current one
+  unsigned int capacity = (queue -> capacity) << 1;
+  void** elements = (void**) memAlloc(sizeof(void*) * capacity);
+  if (!elements)
+    return false;
+
+  // Copy the elements in order so the front lands at index 0
+  unsigned int size = queueSize(queue);
+  unsigned int head = (queue -> front) & (queue -> capacity - 1);
+  unsigned int first = (queue -> capacity) - head;
+  if (first > size)
+    first = size;
+  memcpy(elements, queue -> elements + head, sizeof(void*) * first);
+  memcpy(elements + first, queue -> elements, sizeof(void*) * (size - first));
+
+  // Swap in the new ring
+  trackMemory(MEMORY_QUEUES, sizeof(void*) * (capacity - queue -> capacity));
+  memFree(queue -> elements);
+  queue -> elements = elements;
+  queue -> capacity = capacity;
+  queue -> front = 0;
+  queue -> rear = size;
+  return true;
 }
 
 /**
@@ -291,19 +1104,17 @@ unsigned int queueSize(Queue* queue) {
  * @param element Element to add into the queue
  */
 void enqueue(Queue* queue, void* element) {
-  // Verify that the queue and element exists and that the queue full
-  if (!queue || !element || isFull(queue))
+  // Verify that the queue and element exists
+  if (!queue || !element)
     return;
 
-  // Set the index of the first element to 0
-  if (queue -> front == -1)
-    queue -> front = 0;
+  // Grow the queue if every slot is occupied
+  if (isFull(queue) && !growQueue(queue))
+    return;
 
-  // Increment the index of the last element
+  // Append the element into the queue and increment the rear counter
+  queue -> elements[(queue -> rear) & (queue -> capacity - 1)] = element;
   (queue -> rear)++;
-
-  // Append the element into the queue
-  queue -> elements[queue -> rear] = element;
 }
 
 /**
@@ -317,16 +1128,10 @@ void* dequeue(Queue* queue) {
   if (!queue || isEmpty(queue))
     return NULL;
 
-  // Get the value of the front element
-  void* element = queue -> elements[queue -> front];
-
-  // Increment the index of the first element
+  // Get the value of the front element and increment the front counter
+  void* element = queue -> elements[(queue -> front) & (queue -> capacity - 1)];
   (queue -> front)++;
 
-  // If the queue is now empty, set the index of the first and last elements to -1
-  if ((queue -> front) > (queue -> rear))
-    queue -> front = queue -> rear = -1;
-
   // Return the saved value of the front element
   return element;
 }
@@ -343,15 +1148,181 @@ void* peek(Queue* queue) {
     return NULL;
 
   // Return the value of the front element
-  return queue -> elements[queue -> front];
+  return queue -> elements[(queue -> front) & (queue -> capacity - 1)];
 }
 
-#endif // QUEUE_IMPLEMENTATION
+/**
+ * @brief Get the pointer of the element at an offset from the front of the queue
+ * 
+ * @param queue The pointer to a queue structure
+ * @param index The offset from the front
+ * @return The pointer to the element, NULL if the index is out of range
+ */
+void* getElement(Queue* queue, unsigned int index) {
+  // Verify that the queue exists and the index is in range
+  if (!queue || index >= queueSize(queue))
+    return NULL;
 
-#ifndef HASHMAP_IMPLEMENTATION
-#define HASHMAP_IMPLEMENTATION
+  // Return the value of the element
+  return queue -> elements[(queue -> front + index) & (queue -> capacity - 1)];
+}
 
-#define MAP_MAX 2048
+/**
+ * @brief Create an iterator over the queue, front to rear
+ * 
+ * @param queue The pointer to a queue structure
+ * @return An iterator positioned at the front element
+ */
+QueueIterator iterateQueue(Queue* queue) {
+  return (QueueIterator) { queue, queue ? queue -> front : 0 };
+}
+
+/**
+ * @brief Advance an iterator without modifying the queue
+ * 
+ * @param itr The pointer to a queue iterator
+ * @return The pointer to the next element, NULL once the rear is reached
+ */
+void* nextElement(QueueIterator* itr) {
+  // Verify that the iterator exists and hasn't reached the rear
+  if (!itr || !(itr -> queue) || itr -> index == itr -> queue -> rear)
+    return NULL;
+
+  // Return the element and step forward
+  Queue* queue = itr -> queue;
+  return queue -> elements[(itr -> index)++ & (queue -> capacity - 1)];
+}
+
+/**
+ * @brief Frees a queue (but not its elements)
+ * 
+ * @param queue The pointer to a queue structure
+ */
+void freeQueue(Queue* queue) {
+  // Verify that the queue exists
+  if (!queue)
+    return;
+
+  trackMemory(MEMORY_QUEUES, -(long long) (sizeof(Queue) + sizeof(void*) * queue -> capacity));
+  memFree(queue -> elements);
+  memFree(queue);
+}
+
+/**
+ * @brief The single-producer single-consumer queue structure
+ *
+ * A fixed-capacity, lock-free ring for handing elements between exactly one
+ * producer thread and one consumer thread. Only the producer writes the rear
+ * counter and only the consumer writes the front counter.
+ */
+typedef struct SPSCQueue {
+  void** elements;
+  unsigned int capacity;
+  SDL_atomic_t front, rear;
+} SPSCQueue;
+
+/**
+ * @brief Create an empty single-producer single-consumer queue
+ * 
+ * @param capacity The number of slots (rounded up to a power of two)
+ * @return A queue pointer if successful, NULL if it isn't
+ */
+SPSCQueue* createSPSCQueue(unsigned int capacity) {
+  // Round the capacity up to a power of two
+  unsigned int size = 1;
+  while (size < capacity)
+    size <<= 1;
+
+  // Create a queue pointer
+  SPSCQueue* queue = (SPSCQueue*) memAlloc(sizeof(SPSCQueue));
+  if (!queue)
+    return NULL;
+
+  // Allocate the ring of elements
+  queue -> elements = (void**) memAlloc(sizeof(void*) * size);
+  if (!(queue -> elements)) {
+    memFree(queue);
+    return NULL;
+  }
+  trackMemory(MEMORY_QUEUES, sizeof(SPSCQueue) + sizeof(void*) * size);
+
+  // Set the queue's front and rear to equal 0
+  queue -> capacity = size;
+  SDL_AtomicSet(&(queue -> front), 0);
+  SDL_AtomicSet(&(queue -> rear), 0);
+
+  // Return the empty queue
+  return queue;
+}
+
+/**
+ * @brief Add an element into the queue (producer thread only)
+ * 
+ * @param queue The pointer to a single-producer single-consumer queue
+ * @param element Element to add into the queue
+ * @return true if the element was added, false if the queue is full
+ */
+bool spscEnqueue(SPSCQueue* queue, void* element) {
+  // Verify that the queue and element exists
+  if (!queue || !element)
+    return false;
+
+  // Verify that there is a free slot
+  unsigned int rear = (unsigned int) SDL_AtomicGet(&(queue -> rear));
+  unsigned int front = (unsigned int) SDL_AtomicGet(&(queue -> front));
+  if (rear - front == queue -> capacity)
+    return false;
+
+  // Write the element, then publish it by moving the rear counter
+  queue -> elements[rear & (queue -> capacity - 1)] = element;
+  SDL_MemoryBarrierRelease();
+  SDL_AtomicSet(&(queue -> rear), (int) (rear + 1));
+  return true;
+}
+
+/**
+ * @brief Removes the front element from the queue (consumer thread only)
+ * 
+ * @param queue The pointer to a single-producer single-consumer queue
+ * @return The pointer to the front element, NULL if the queue is empty
+ */
+void* spscDequeue(SPSCQueue* queue) {
+  // Verify that the queue exists and isn't empty
+  if (!queue)
+    return NULL;
+  unsigned int front = (unsigned int) SDL_AtomicGet(&(queue -> front));
+  unsigned int rear = (unsigned int) SDL_AtomicGet(&(queue -> rear));
+  if (front == rear)
+    return NULL;
+
+  // Read the element, then release the slot by moving the front counter
+  SDL_MemoryBarrierAcquire();
+  void* element = queue -> elements[front & (queue -> capacity - 1)];
+  SDL_AtomicSet(&(queue -> front), (int) (front + 1));
+  return element;
+}
+
+/**
+ * @brief Frees a single-producer single-consumer queue (but not its elements)
+ * 
+ * @param queue The pointer to a single-producer single-consumer queue
+ */
+void freeSPSCQueue(SPSCQueue* queue) {
+  // Verify that the queue exists
+  if (!queue)
+    return;
+
+  trackMemory(MEMORY_QUEUES, -(long long) (sizeof(SPSCQueue) + sizeof(void*) * queue -> capacity));
+  memFree(queue -> elements);
+  memFree(queue);
+}
+
+#endif // QUEUE_IMPLEMENTATION
+
+#ifndef HASHMAP_IMPLEMENTATION
+#define HASHMAP_IMPLEMENTATION
+
+#define MAP_MAX 2069
 
 // Define HashMap
 typedef void** HashMap;
@@ -362,7 +1333,10 @@ typedef void** HashMap;
  * @return A hash map pointer if successful, NULL if it isn't
  */
 HashMap* createHashMap(void) {
-  return (HashMap*) malloc(sizeof(HashMap) * MAP_MAX);
+  HashMap* map = (HashMap*) memCalloc(MAP_MAX, sizeof(HashMap));
+  if (map)
+    trackMemory(MEMORY_QUEUES, sizeof(HashMap) * MAP_MAX);
+  return map;
 }
 
 /**
@@ -371,14 +1345,14 @@ HashMap* createHashMap(void) {
  * @param key String to hash
  * @return An unsigned int for the hash code
  */
-unsigned int hash(char* key) {
+unsigned int hash(const char* key) {
   // Calculate the alpha by the sum of ASCII values of characters multiplied by their respective order in the string
   register unsigned int itr, alpha = 0;
   for (itr = 0; itr < strlen(key); itr++)
     alpha += ((int) key[itr]) * (itr + 1);
 
-  // Return the modulus of the alpha and a prime number
-  return alpha % 2069;
+  // Return the modulus of the alpha and a prime number (the number of slots)
+  return alpha % MAP_MAX;
 }
 
 /**
@@ -442,6 +1416,460 @@ void delete(HashMap* map, char* key) {
 
 #endif // HASHMAP_IMPLEMENTATION
 
+#ifndef PACK_IMPLEMENTATION
+#define PACK_IMPLEMENTATION
+
+#ifdef __linux__
+  #include <sys/mman.h>
+#endif
+
+#define PACK_VERSION 1
+#define PACK_ALIGNMENT 64
+
+/**
+ * @brief The asset types stored in a pack.
+ */
+typedef enum PACK_TYPE {
+  PACK_RAW,       // Bytes as found on disk, followed by a NUL (shaders, metadata)
+  PACK_IMAGE      // Pre-decoded bottom-up RGBA rows
+} PACK_TYPE;
+
+/**
+ * @brief The pack file header.
+ *
+ * A pack is laid out as the header, the entry table, an open-addressed hash
+ * table of entry indices (plus one, 0 when empty), the NUL-terminated names
+ * and finally the asset data, each aligned to PACK_ALIGNMENT. Every field is
+ * stored little-endian and naturally aligned so the file is used in place.
+ */
+typedef struct PackHeader {
+  char magic[8];            // "NANIPACK"
+  uint32_t version;         // PACK_VERSION
+  uint32_t count;           // The number of entries
+  uint32_t buckets;         // The number of hash table slots (a power of two)
+  uint32_t reserved;
+} PackHeader;
+
+/**
+ * @brief A pack entry.
+ */
+typedef struct PackEntry {
+  uint64_t hash;            // The hash of the name
+  uint64_t offset;          // The offset of the data from the start of the file
+  uint64_t size;            // The size of the data in bytes
+  uint32_t name;            // The offset of the name from the start of the file
+  uint32_t type;            // The PACK_TYPE
+  uint32_t width, height;   // The image dimensions (0 for raw assets)
+} PackEntry;
+
+/**
+ * @brief A loaded pack.
+ */
+typedef struct Pack {
+  unsigned char* data;      // The mapped file
+  size_t size;              // The size of the file
+  bool mapped;              // Whether data is mapped (or read into memory)
+  const PackHeader* header;
+  const PackEntry* entries;
+  const uint32_t* table;
+} Pack;
+
+/**
+ * @brief A zero-copy view of an asset in a pack.
+ */
+typedef struct Asset {
+  const char* name;
+  const void* data;
+  size_t size;
+  PACK_TYPE type;
+  int width, height;
+} Asset;
+
+/**
+ * @brief Hash an asset name (64-bit FNV-1a).
+ * 
+ * @param name The asset name
+ * @return The hash
+ */
+uint64_t hashAsset(const char* name) {
+  uint64_t value = 14695981039346656037ULL;
+  while (*name) {
+    value ^= (unsigned char) *name++;
+    value *= 1099511628211ULL;
+  }
+
+  return value;
+}
+
+/**
+ * @brief Reads a whole file in binary mode.
+ * 
+ * @param filename The filename to read.
+ * @param size Set to the size of the file.
+ * @return The file contents followed by a NUL, NULL if the file can't be read.
+ */
+static unsigned char* readPackFile(const char* filename, size_t* size) {
+  FILE* file = fopen(filename, "rb");
+  if (!file)
+    return NULL;
+
+  // Measure the file
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (length < 0) {
+    fclose(file);
+    return NULL;
+  }
+
+  // Read the file
+  unsigned char* data = (unsigned char*) memAlloc(length + 1);
+  if (!data || (length && fread(data, length, 1, file) != 1)) {
+    memFree(data);
+    fclose(file);
+    return NULL;
+  }
+  data[length] = '\0';
+  fclose(file);
+
+  *size = (size_t) length;
+  return data;
+}
+
+/**
+ * @brief Build a pack from a list of files (BMP files are stored pre-decoded).
+ * 
+ * @param filename The pack filename
+ * @param files The files to pack (their paths become the asset names)
+ * @param count The number of files
+ * @return true if successful
+ */
+bool buildPack(const char* filename, const char** files, unsigned int count) {
+  // Verify the filename and files
+  if (!filename || (!files && count)) {
+    fprintf(stderr, "Error: Invalid pack filename or files.\n");
+    return false;
+  }
+
+  // Size the hash table to at most half full
+  uint32_t buckets = 1;
+  while (buckets < count * 2)
+    buckets <<= 1;
+
+  PackEntry* entries = (PackEntry*) memCalloc(count ? count : 1, sizeof(PackEntry));
+  unsigned char** contents = (unsigned char**) memCalloc(count ? count : 1, sizeof(unsigned char*));
+  uint32_t* table = (uint32_t*) memCalloc(buckets, sizeof(uint32_t));
+  if (!entries || !contents || !table)
+    error("Failed to allocate pack!");
+
+  // Lay out the names after the tables (name offsets are 32-bit)
+  uint64_t offset = sizeof(PackHeader) + sizeof(PackEntry) * count + sizeof(uint32_t) * buckets;
+  register unsigned int itr;
+  for (itr = 0; itr < count; itr++) {
+    entries[itr].name = (uint32_t) offset;
+    offset += strlen(files[itr]) + 1;
+  }
+  if (offset > UINT32_MAX) {
+    fprintf(stderr, "Error: Too many pack names.\n");
+    memFree(contents);
+    memFree(entries);
+    memFree(table);
+    return false;
+  }
+
+  // Load every asset and lay out its data
+  bool success = true;
+  for (itr = 0; itr < count && success; itr++) {
+    PackEntry* entry = &entries[itr];
+    entry -> hash = hashAsset(files[itr]);
+
+    const char* extension = strrchr(files[itr], '.');
+    if (extension && strcmp(extension, ".bmp") == 0) {
+      // Decode images so they can be uploaded straight from the pack
+      BMP* image = loadBMP(files[itr]);
+      contents[itr] = image ? decodeBMP(image) : NULL;
+      if (contents[itr]) {
+        entry -> type = PACK_IMAGE;
+        entry -> width = (uint32_t) image -> header.width;
+        entry -> height = (uint32_t) abs((int32_t) image -> header.height);
+        entry -> size = (uint64_t) (entry -> width) * (entry -> height) * 4;
+      }
+      if (image)
+        freeBMP(image);
+    } else {
+      // Keep everything else as-is, with a NUL so text can be used in place
+      size_t size;
+      contents[itr] = readPackFile(files[itr], &size);
+      entry -> type = PACK_RAW;
+      entry -> size = size;
+    }
+
+    if (!contents[itr]) {
+      fprintf(stderr, "Error: Could not pack \"%s\".\n", files[itr]);
+      success = false;
+      break;
+    }
+
+    offset = (offset + PACK_ALIGNMENT - 1) & ~(uint64_t) (PACK_ALIGNMENT - 1);
+    entry -> offset = offset;
+    offset += entry -> size + (entry -> type == PACK_RAW);
+
+    // Insert the entry into the hash table (linear probing)
+    uint32_t slot = (uint32_t) (entry -> hash) & (buckets - 1);
+    while (table[slot])
+      slot = (slot + 1) & (buckets - 1);
+    table[slot] = itr + 1;
+  }
+
+  // Write the pack
+  FILE* file = success ? fopen(filename, "wb") : NULL;
+  if (success && !file) {
+    fprintf(stderr, "Error: Could not open file.\n");
+    success = false;
+  }
+  if (success) {
+    PackHeader header = { "NANIPACK", PACK_VERSION, count, buckets, 0 };
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(entries, sizeof(PackEntry), count, file);
+    fwrite(table, sizeof(uint32_t), buckets, file);
+    for (itr = 0; itr < count; itr++)
+      fwrite(files[itr], strlen(files[itr]) + 1, 1, file);
+    for (itr = 0; itr < count; itr++) {
+      static const unsigned char padding[PACK_ALIGNMENT];
+      long position = ftell(file);
+      fwrite(padding, (size_t) (entries[itr].offset - position), 1, file);
+      fwrite(contents[itr], entries[itr].size + (entries[itr].type == PACK_RAW), 1, file);
+    }
+    if (ferror(file)) {
+      fprintf(stderr, "Error: Could not write to file.\n");
+      success = false;
+    }
+    fclose(file);
+  }
+
+  // Free the assets
+  for (itr = 0; itr < count; itr++)
+    memFree(contents[itr]);
+  memFree(contents);
+  memFree(entries);
+  memFree(table);
+
+  return success;
+}
+
+/**
+ * @brief Map a whole file into memory (reading it if it can't be mapped).
+ * 
+ * @param filename The filename
+ * @param size Set to the size of the file
+ * @param mapped Set to whether the file is mapped (or read into memory)
+ * @return The contents, NULL if the file couldn't be opened
+ */
+static unsigned char* mapFile(const char* filename, size_t* size, bool* mapped) {
+  *mapped = false;
+
+  #ifdef __linux__
+    // Map the whole file; pages are faulted in as they're touched
+    FILE* file = fopen(filename, "rb");
+    if (file) {
+      fseek(file, 0, SEEK_END);
+      long length = ftell(file);
+      void* data = length > 0 ? mmap(NULL, (size_t) length, PROT_READ, MAP_PRIVATE, fileno(file), 0) : MAP_FAILED;
+      fclose(file);
+      if (data != MAP_FAILED) {
+        *size = (size_t) length;
+        *mapped = true;
+        return (unsigned char*) data;
+      }
+    }
+  #endif
+
+  // Fall back to reading the file
+  return readPackFile(filename, size);
+}
+
+/**
+ * @brief Release a file from mapFile().
+ * 
+ * @param data The contents
+ * @param size The size of the file
+ * @param mapped Whether the file is mapped
+ */
+static void unmapFile(unsigned char* data, size_t size, bool mapped) {
+  #ifdef __linux__
+    if (mapped) {
+      munmap(data, size);
+      return;
+    }
+  #endif
+  (void) size;
+  (void) mapped;
+  memFree(data);
+}
+
+/**
+ * @brief Close a pack (invalidating every view into it).
+ * 
+ * @param pack The pack
+ */
+void closePack(Pack* pack) {
+  // Verify that the pack exists
+  if (!pack)
+    return;
+
+  // Unmap or free the file
+  unmapFile(pack -> data, pack -> size, pack -> mapped);
+  trackMemory(MEMORY_ASSETS, -(long long) (sizeof(Pack) + pack -> size));
+  memFree(pack);
+}
+
+/**
+ * @brief Verify that a pack's tables, names and data lie inside the file.
+ * 
+ * @param pack The pack (its header already verified)
+ * @return true if every entry can be used in place
+ */
+static bool validatePack(const Pack* pack) {
+  // The tables must fit, and the hash table must be a power of two with room to spare
+  uint64_t count = pack -> header -> count, buckets = pack -> header -> buckets;
+  if (buckets == 0 || (buckets & (buckets - 1)) || count >= buckets || sizeof(PackHeader) + sizeof(PackEntry) * count + sizeof(uint32_t) * buckets > pack -> size)
+    return false;
+
+  // Every slot must be empty or point at an entry, leaving an empty slot to end each probe
+  register uint64_t itr, used = 0;
+  for (itr = 0; itr < buckets; itr++) {
+    if (pack -> table[itr] > count)
+      return false;
+    used += pack -> table[itr] != 0;
+  }
+  if (used >= buckets)
+    return false;
+
+  // Every name must end inside the file, and every asset (ending in a NUL if raw) must lie inside it
+  for (itr = 0; itr < count; itr++) {
+    const PackEntry* entry = &(pack -> entries[itr]);
+    uint64_t size = entry -> size + (entry -> type == PACK_RAW);
+    if (entry -> name >= pack -> size || !memchr(pack -> data + entry -> name, '\0', pack -> size - entry -> name))
+      return false;
+    if (entry -> type != PACK_RAW && entry -> type != PACK_IMAGE)
+      return false;
+    if (entry -> offset > pack -> size || entry -> size >= UINT64_MAX || size > pack -> size - entry -> offset)
+      return false;
+    if (entry -> type == PACK_IMAGE && (uint64_t) (entry -> width) * (entry -> height) * 4 != entry -> size)
+      return false;
+    if (entry -> type == PACK_RAW && pack -> data[entry -> offset + entry -> size] != '\0')
+      return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Open a pack, mapping it into memory.
+ * 
+ * @param filename The pack filename
+ * @return A pack pointer if successful, NULL if it isn't
+ */
+Pack* openPack(const char* filename) {
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  // Verify the filename
+  if (!filename)
+    return NULL;
+
+  Pack* pack = (Pack*) memCalloc(1, sizeof(Pack));
+  if (!pack)
+    return NULL;
+
+  // Map the whole file; pages are faulted in as assets are touched
+  pack -> data = mapFile(filename, &(pack -> size), &(pack -> mapped));
+  trackMemory(MEMORY_ASSETS, sizeof(Pack) + pack -> size);
+
+  // Verify the header
+  pack -> header = (const PackHeader*) pack -> data;
+  if (!(pack -> data) || pack -> size < sizeof(PackHeader) || memcmp(pack -> header -> magic, "NANIPACK", 8) != 0 || pack -> header -> version != PACK_VERSION) {
+    fprintf(stderr, "Error: Invalid pack \"%s\".\n", filename);
+    closePack(pack);
+    return NULL;
+  }
+
+  pack -> entries = (const PackEntry*) (pack -> data + sizeof(PackHeader));
+  pack -> table = (const uint32_t*) (pack -> entries + pack -> header -> count);
+  if (!validatePack(pack)) {
+    fprintf(stderr, "Error: Invalid pack \"%s\".\n", filename);
+    closePack(pack);
+    return NULL;
+  }
+
+  recordLoadMetrics(LOAD_PACK, start);
+  return pack;
+}
+
+/**
+ * @brief Probe a pack's hash table for an asset.
+ * 
+ * @param pack The pack
+ * @param hash The hash of the asset name
+ * @param name The asset name (NULL to take the first entry with the hash)
+ * @param asset Set to a view of the asset
+ * @return true if the asset was found
+ */
+static bool probePack(Pack* pack, uint64_t hash, const char* name, Asset* asset) {
+  // Verify that the pack and asset exist
+  if (!pack || !asset || !(pack -> header -> buckets))
+    return false;
+
+  // Probe the hash table, stepping past names that only share the hash
+  uint32_t mask = pack -> header -> buckets - 1;
+  uint32_t slot = (uint32_t) hash & mask;
+  while (pack -> table[slot]) {
+    const PackEntry* entry = &(pack -> entries[pack -> table[slot] - 1]);
+    if (entry -> hash == hash && (!name || strcmp((const char*) (pack -> data + entry -> name), name) == 0)) {
+      asset -> name = (const char*) (pack -> data + entry -> name);
+      asset -> data = pack -> data + entry -> offset;
+      asset -> size = (size_t) entry -> size;
+      asset -> type = (PACK_TYPE) entry -> type;
+      asset -> width = (int) entry -> width;
+      asset -> height = (int) entry -> height;
+      return true;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  return false;
+}
+
+/**
+ * @brief Find an asset in a pack by the hash of its name.
+ * 
+ * @param pack The pack
+ * @param hash The hash of the asset name
+ * @param asset Set to a view of the asset
+ * @return true if the asset was found
+ */
+bool findAssetByHash(Pack* pack, uint64_t hash, Asset* asset) {
+  return probePack(pack, hash, NULL, asset);
+}
+
+/**
+ * @brief Find an asset in a pack by name.
+ * 
+ * @param pack The pack
+ * @param name The asset name
+ * @param asset Set to a view of the asset
+ * @return true if the asset was found
+ */
+bool findAsset(Pack* pack, const char* name, Asset* asset) {
+  // Verify that the name exists
+  if (!name)
+    return false;
+
+  // Compare the name too, in case two names share a hash
+  return probePack(pack, hashAsset(name), name, asset);
+}
+
+#endif // PACK_IMPLEMENTATION
+
 #ifdef NANITE_IMPLEMENTATION
   #define NANITE_INPUT_INCLUDE
   #define NANITE_INPUT_IMPLEMENTATION
@@ -485,6 +1913,9 @@ typedef enum KEY {
   KEY_LEFT, KEY_RIGHT, KEY_UP, KEY_DOWN,
   KEY_LSHIFT, KEY_SPACE,
 
+  KEY_F1, KEY_F2, KEY_F3, KEY_F4, KEY_F5, KEY_F6,
+  KEY_F7, KEY_F8, KEY_F9, KEY_F10, KEY_F11, KEY_F12,
+
   KEY_MAX
 } KEY;
 
@@ -497,8 +1928,65 @@ typedef enum KEY_STATE {
   KEY_STATE_HELD
 } KEY_STATE;
 
-// Key state array.
-static KEY_STATE keystate[KEY_MAX];
+/**
+ * @brief Key modifier enumeration (combined with |).
+ */
+typedef enum KEY_MOD {
+  KEY_MOD_NONE = 0,
+  KEY_MOD_SHIFT = 1 << 0,
+  KEY_MOD_CTRL = 1 << 1,
+  KEY_MOD_ALT = 1 << 2
+} KEY_MOD;
+
+#define KEY_WORDS ((SDL_NUM_SCANCODES + 63) / 64)
+#define KEY_MODS 8              // Every combination of KEY_MODs
+#define ACTION_MAX 64
+#define ACTION_BINDINGS 4
+
+/**
+ * @brief The ActionBinding structure (keys that trigger an action while the modifiers are held).
+ */
+typedef struct ActionBinding {
+  uint64_t keys[KEY_WORDS];   // Any of these scancodes
+  unsigned int modifiers;     // All of these KEY_MODs
+} ActionBinding;
+
+/**
+ * @brief The Action structure (an action's bindings).
+ */
+typedef struct Action {
+  ActionBinding bindings[ACTION_BINDINGS];
+  unsigned int count;
+} Action;
+
+// Scancode of every key.
+static const SDL_Scancode keyScancodes[KEY_MAX] = {
+  SDL_SCANCODE_A, SDL_SCANCODE_B, SDL_SCANCODE_C, SDL_SCANCODE_D, SDL_SCANCODE_E, SDL_SCANCODE_F, SDL_SCANCODE_G,
+  SDL_SCANCODE_H, SDL_SCANCODE_I, SDL_SCANCODE_J, SDL_SCANCODE_K, SDL_SCANCODE_L, SDL_SCANCODE_M, SDL_SCANCODE_N,
+  SDL_SCANCODE_O, SDL_SCANCODE_P, SDL_SCANCODE_Q, SDL_SCANCODE_R, SDL_SCANCODE_S, SDL_SCANCODE_T, SDL_SCANCODE_U,
+  SDL_SCANCODE_V, SDL_SCANCODE_W, SDL_SCANCODE_X, SDL_SCANCODE_Y, SDL_SCANCODE_Z,
+
+  SDL_SCANCODE_0, SDL_SCANCODE_1, SDL_SCANCODE_2, SDL_SCANCODE_3, SDL_SCANCODE_4, SDL_SCANCODE_5, SDL_SCANCODE_6,
+  SDL_SCANCODE_7, SDL_SCANCODE_8, SDL_SCANCODE_9,
+
+  SDL_SCANCODE_ESCAPE, SDL_SCANCODE_RETURN, SDL_SCANCODE_LCTRL, SDL_SCANCODE_LALT,
+  SDL_SCANCODE_LEFT, SDL_SCANCODE_RIGHT, SDL_SCANCODE_UP, SDL_SCANCODE_DOWN,
+  SDL_SCANCODE_LSHIFT, SDL_SCANCODE_SPACE,
+
+  SDL_SCANCODE_F1, SDL_SCANCODE_F2, SDL_SCANCODE_F3, SDL_SCANCODE_F4, SDL_SCANCODE_F5, SDL_SCANCODE_F6,
+  SDL_SCANCODE_F7, SDL_SCANCODE_F8, SDL_SCANCODE_F9, SDL_SCANCODE_F10, SDL_SCANCODE_F11, SDL_SCANCODE_F12
+};
+
+// Key state bitsets (one bit per scancode).
+static uint64_t keysDown[KEY_WORDS];      // Down now (updated by events)
+static uint64_t keysLast[KEY_WORDS];      // Down as of the last processed frame
+static uint64_t keysPressed[KEY_WORDS];   // Went down this frame
+static uint64_t keysReleased[KEY_WORDS];  // Went up this frame
+
+// Action map and state bitsets (one bit per action).
+static Action actions[ACTION_MAX];
+static uint64_t actionsDown, actionsPressed, actionsReleased;
+static uint64_t keyActions[KEY_MODS][SDL_NUM_SCANCODES];  // The actions a scancode triggers under each set of held modifiers
 
 /**
  * @brief Check if a key is pressed.
@@ -509,108 +1997,933 @@ static KEY_STATE keystate[KEY_MAX];
 bool keypress(KEY key);
 
 /**
- * @brief Initializes the key state array.
+ * @brief Check if a key went down this frame.
+ * 
+ * @param key The key to check.
+ * @return true if the key was pressed this frame.
  */
-static void initKeystates(void);
+bool keyPressed(KEY key);
 
 /**
- * @brief Updates the key state array.
+ * @brief Check if a key went up this frame.
  * 
- * @param keyboard The SDL keyboard event.
- * @param state The state of the key.
+ * @param key The key to check.
+ * @return true if the key was released this frame.
  */
-static void updateKeystates(uint8_t keyboard, KEY_STATE* state);
+bool keyReleased(KEY key);
 
 /**
- * @brief Processes the SDL keyboard event.
+ * @brief Get the state of a key.
+ * 
+ * @param key The key to check.
+ * @return The key state (pressed on the frame it went down, held after).
  */
-static void processInput(void);
-
-#endif // NANITE_INPUT_INCLUDE
-
-#ifdef NANITE_INPUT_IMPLEMENTATION
+KEY_STATE getKeystate(KEY key);
 
 /**
- * @brief Check if a key is pressed.
+ * @brief Binds a key (with modifiers) to an action.
  * 
- * @param key The key to check.
- * @return true if the key is pressed.
+ * @param action The action (below ACTION_MAX).
+ * @param key The key.
+ * @param modifiers The KEY_MODs that must be held too.
+ * @return true if the key was bound.
  */
-bool keypress(KEY key) {
-  return keystate[key] != KEY_STATE_RELEASED;
-}
+bool bindAction(unsigned int action, KEY key, unsigned int modifiers);
 
 /**
- * @brief Initializes the key state array.
+ * @brief Removes every binding of an action.
+ * 
+ * @param action The action.
  */
-static void initKeystates(void) {
-  for (int i = 0; i < KEY_MAX; i++) {
-    keystate[i] = KEY_STATE_RELEASED;
-  }
-}
+void unbindAction(unsigned int action);
 
 /**
- * @brief Updates the key state array.
+ * @brief Check if an action is held.
  * 
- * @param keyboard The SDL keyboard event.
- * @param state The state of the key.
+ * @param action The action.
+ * @return true if any of its bindings is held.
  */
-static void updateKeystates(uint8_t keyboard, KEY_STATE* state) {
-  if (keyboard) {
-    if (*state > KEY_STATE_RELEASED)
-      *state = KEY_STATE_HELD;
-    else
-      *state = KEY_STATE_PRESSED;
-  } else
-    *state = KEY_STATE_RELEASED;
-}
+bool actionHeld(unsigned int action);
 
 /**
- * @brief Processes the SDL keyboard event.
+ * @brief Check if an action started this frame.
+ * 
+ * @param action The action.
+ * @return true if the action was triggered this frame.
  */
-static void processInput(void) {
-  const uint8_t* state = SDL_GetKeyboardState(NULL);
+bool actionPressed(unsigned int action);
 
-  // TODO: Update keystate array using configurable key mappings.
-  updateKeystates(state[SDL_SCANCODE_W], &keystate[KEY_W]);
-  updateKeystates(state[SDL_SCANCODE_A], &keystate[KEY_A]);
-  updateKeystates(state[SDL_SCANCODE_S], &keystate[KEY_S]);
-  updateKeystates(state[SDL_SCANCODE_D], &keystate[KEY_D]);
-  updateKeystates(state[SDL_SCANCODE_F], &keystate[KEY_F]);
-
-  updateKeystates(state[SDL_SCANCODE_ESCAPE], &keystate[KEY_ESCAPE]);
-  updateKeystates(state[SDL_SCANCODE_LSHIFT], &keystate[KEY_LSHIFT]);
-  updateKeystates(state[SDL_SCANCODE_SPACE], &keystate[KEY_SPACE]);
-  updateKeystates(state[SDL_SCANCODE_LALT], &keystate[KEY_LALT]);
-}
-
-#endif // NANITE_INPUT_IMPLEMENTATION
+/**
+ * @brief Check if an action stopped this frame.
+ * 
+ * @param action The action.
+ * @return true if the action was let go this frame.
+ */
+bool actionReleased(unsigned int action);
 
-#ifdef NANITE_RENDER_INCLUDE
+/**
+ * @brief Rebuilds the scancode to action masks from the bindings.
+ */
+static void mapActions(void);
 
 /**
- * @brief The Entity structure
+ * @brief Initializes the key state bitsets.
  */
-typedef struct Entity {  
+static void initKeystates(void);
+
+/**
+ * @brief Updates the key state bitsets from an SDL event.
+ * 
+ * @param event The SDL event.
+ */
+static void handleInputEvent(const SDL_Event* event);
+
+/**
+ * @brief Computes the key and action edges of the frame.
+ */
+static void processInput(void);
+
+#if !defined(NO_NANITE_RENDER) && !defined(NO_NANITE_WINDOW)
+/**
+ * @brief Check if any key is held down (lazy loop only).
+ * 
+ * @return true if a key is down.
+ */
+static bool inputHeld(void);
+#endif
+
+#endif // NANITE_INPUT_INCLUDE
+
+#ifdef NANITE_INPUT_IMPLEMENTATION
+
+/**
+ * @brief Tests a scancode's bit in a key bitset.
+ * 
+ * @param bits The key bitset.
+ * @param scancode The scancode.
+ * @return true if the bit is set.
+ */
+static inline bool testKey(const uint64_t* bits, unsigned int scancode) {
+  return (bits[scancode >> 6] >> (scancode & 63)) & 1;
+}
+
+/**
+ * @brief Check if a key is pressed.
+ * 
+ * @param key The key to check.
+ * @return true if the key is pressed.
+ */
+bool keypress(KEY key) {
+  return key < KEY_MAX && testKey(keysLast, keyScancodes[key]);
+}
+
+/**
+ * @brief Check if a key went down this frame.
+ * 
+ * @param key The key to check.
+ * @return true if the key was pressed this frame.
+ */
+bool keyPressed(KEY key) {
+  return key < KEY_MAX && testKey(keysPressed, keyScancodes[key]);
+}
+
+/**
+ * @brief Check if a key went up this frame.
+ * 
+ * @param key The key to check.
+ * @return true if the key was released this frame.
+ */
+bool keyReleased(KEY key) {
+  return key < KEY_MAX && testKey(keysReleased, keyScancodes[key]);
+}
+
+/**
+ * @brief Get the state of a key.
+ * 
+ * @param key The key to check.
+ * @return The key state (pressed on the frame it went down, held after).
+ */
+KEY_STATE getKeystate(KEY key) {
+  if (keyPressed(key))
+    return KEY_STATE_PRESSED;
+  return keypress(key) ? KEY_STATE_HELD : KEY_STATE_RELEASED;
+}
+
+/**
+ * @brief Binds a key (with modifiers) to an action.
+ * 
+ * @param action The action (below ACTION_MAX).
+ * @param key The key.
+ * @param modifiers The KEY_MODs that must be held too.
+ * @return true if the key was bound.
+ */
+bool bindAction(unsigned int action, KEY key, unsigned int modifiers) {
+  // Verify the action and key
+  if (action >= ACTION_MAX || key >= KEY_MAX)
+    return false;
+
+  // Add the key to the binding with the same modifiers, or start a new one
+  Action* entry = &actions[action];
+  register unsigned int itr;
+  for (itr = 0; itr < entry -> count; itr++)
+    if (entry -> bindings[itr].modifiers == modifiers)
+      break;
+  if (itr == entry -> count) {
+    if (entry -> count == ACTION_BINDINGS)
+      return false;
+    memset(&(entry -> bindings[itr]), 0, sizeof(ActionBinding));
+    entry -> bindings[itr].modifiers = modifiers;
+    entry -> count++;
+  }
+
+  unsigned int scancode = keyScancodes[key];
+  entry -> bindings[itr].keys[scancode >> 6] |= 1ULL << (scancode & 63);
+  mapActions();
+  return true;
+}
+
+/**
+ * @brief Removes every binding of an action.
+ * 
+ * @param action The action.
+ */
+void unbindAction(unsigned int action) {
+  if (action < ACTION_MAX) {
+    actions[action].count = 0;
+    mapActions();
+  }
+}
+
+/**
+ * @brief Check if an action is held.
+ * 
+ * @param action The action.
+ * @return true if any of its bindings is held.
+ */
+bool actionHeld(unsigned int action) {
+  return action < ACTION_MAX && ((actionsDown >> action) & 1);
+}
+
+/**
+ * @brief Check if an action started this frame.
+ * 
+ * @param action The action.
+ * @return true if the action was triggered this frame.
+ */
+bool actionPressed(unsigned int action) {
+  return action < ACTION_MAX && ((actionsPressed >> action) & 1);
+}
+
+/**
+ * @brief Check if an action stopped this frame.
+ * 
+ * @param action The action.
+ * @return true if the action was let go this frame.
+ */
+bool actionReleased(unsigned int action) {
+  return action < ACTION_MAX && ((actionsReleased >> action) & 1);
+}
+
+/**
+ * @brief Rebuilds the scancode to action masks from the bindings.
+ */
+static void mapActions(void) {
+  memset(keyActions, 0, sizeof(keyActions));
+
+  // Add every bound scancode to each set of modifiers that includes the binding's
+  register unsigned int action, binding, word, modifiers;
+  for (action = 0; action < ACTION_MAX; action++) {
+    for (binding = 0; binding < actions[action].count; binding++) {
+      const ActionBinding* entry = &(actions[action].bindings[binding]);
+      for (word = 0; word < KEY_WORDS; word++) {
+        uint64_t keys = entry -> keys[word];
+        while (keys) {
+          unsigned int scancode = word * 64 + __builtin_ctzll(keys);
+          keys &= keys - 1;
+          for (modifiers = 0; modifiers < KEY_MODS; modifiers++)
+            if ((entry -> modifiers & modifiers) == entry -> modifiers)
+              keyActions[modifiers][scancode] |= 1ULL << action;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * @brief Initializes the key state bitsets.
+ */
+static void initKeystates(void) {
+  memset(keysDown, 0, sizeof(keysDown));
+  memset(keysLast, 0, sizeof(keysLast));
+  memset(keysPressed, 0, sizeof(keysPressed));
+  memset(keysReleased, 0, sizeof(keysReleased));
+  actionsDown = actionsPressed = actionsReleased = 0;
+}
+
+/**
+ * @brief Updates the key state bitsets from an SDL event.
+ * 
+ * @param event The SDL event.
+ */
+static void handleInputEvent(const SDL_Event* event) {
+  // Only keyboard events change the key state
+  if (event -> type != SDL_KEYDOWN && event -> type != SDL_KEYUP)
+    return;
+
+  unsigned int scancode = event -> key.keysym.scancode;
+  if (scancode >= SDL_NUM_SCANCODES)
+    return;
+
+  if (event -> type == SDL_KEYDOWN)
+    keysDown[scancode >> 6] |= 1ULL << (scancode & 63);
+  else
+    keysDown[scancode >> 6] &= ~(1ULL << (scancode & 63));
+}
+
+/**
+ * @brief Computes the key and action edges of the frame.
+ */
+static void processInput(void) {
+  // Find the edges a word at a time
+  register unsigned int word;
+  for (word = 0; word < KEY_WORDS; word++) {
+    uint64_t changed = keysDown[word] ^ keysLast[word];
+    keysPressed[word] = changed & keysDown[word];
+    keysReleased[word] = changed & keysLast[word];
+    keysLast[word] = keysDown[word];
+  }
+
+  // Gather the held modifiers (either side counts)
+  unsigned int modifiers = KEY_MOD_NONE;
+  if (testKey(keysLast, SDL_SCANCODE_LSHIFT) || testKey(keysLast, SDL_SCANCODE_RSHIFT))
+    modifiers |= KEY_MOD_SHIFT;
+  if (testKey(keysLast, SDL_SCANCODE_LCTRL) || testKey(keysLast, SDL_SCANCODE_RCTRL))
+    modifiers |= KEY_MOD_CTRL;
+  if (testKey(keysLast, SDL_SCANCODE_LALT) || testKey(keysLast, SDL_SCANCODE_RALT))
+    modifiers |= KEY_MOD_ALT;
+
+  // Resolve the actions from the held keys (only the set bits are visited)
+  uint64_t down = 0;
+  const uint64_t* map = keyActions[modifiers & (KEY_MODS - 1)];
+  for (word = 0; word < KEY_WORDS; word++) {
+    uint64_t keys = keysLast[word];
+    while (keys) {
+      down |= map[word * 64 + __builtin_ctzll(keys)];
+      keys &= keys - 1;
+    }
+  }
+  actionsPressed = down & ~actionsDown;
+  actionsReleased = actionsDown & ~down;
+  actionsDown = down;
+}
+
+#if !defined(NO_NANITE_RENDER) && !defined(NO_NANITE_WINDOW)
+/**
+ * @brief Check if any key is held down (lazy loop only).
+ * 
+ * @return true if a key is down.
+ */
+static bool inputHeld(void) {
+  uint64_t any = 0;
+  register unsigned int word;
+  for (word = 0; word < KEY_WORDS; word++)
+    any |= keysDown[word];
+  return any != 0;
+}
+#endif
+
+#endif // NANITE_INPUT_IMPLEMENTATION
+
+#ifdef NANITE_RENDER_INCLUDE
+
+/**
+ * @brief The Entity structure
+ */
+typedef struct Entity {  
   const char* ID;
   int width, height;
-  float position[3];
+  float position[3];      // The world position (computed from the parent's for children)
   float vertices[12];
   unsigned int indices[6];
+  unsigned int version;   // Incremented whenever the entity changes
+  unsigned int proxy;     // Index of the entity's broadphase proxy
+  struct Scene* scene;    // The scene whose block holds the entity (NULL if allocated alone)
+  struct Shader* shaders; // The shaders drawing the entity (linked through their next)
+  float local[3];         // The position relative to the parent (the world position without one)
+  struct Entity* parent;  // The entity this one moves with (NULL for none)
+  unsigned int children;  // The number of entities attached to this one
+  unsigned int node;      // Index in the transform order + 1 (0 outside any hierarchy)
+  unsigned int depth;     // The number of ancestors (as of the last sort)
+  unsigned int moved;     // The transform pass that last moved the entity
+  bool dirty;             // Whether the local position changed since the world position was computed
 } Entity;
 
+/**
+ * @brief The Proxy structure (an entity's bounds in the broadphase, kept sorted by min[0])
+ */
+typedef struct Proxy {
+  float min[2], max[2];
+  Entity* entity;         // NULL once the entity is destroyed (removed on the next query)
+} Proxy;
+
+/**
+ * @brief The EntityPair structure (two entities whose bounds overlap)
+ */
+typedef struct EntityPair {
+  Entity* a;
+  Entity* b;
+} EntityPair;
+
+/**
+ * @brief The PairList structure (pairs found by one thread)
+ */
+typedef struct PairList {
+  EntityPair* pairs;
+  unsigned int count, capacity;
+} PairList;
+
+/**
+ * @brief The Sweeper structure (a thread sweeping a slice of the proxies)
+ */
+typedef struct Sweeper {
+  SDL_Thread* thread;
+  SDL_sem* start;
+  SDL_sem* done;
+  PairList* list;
+  unsigned int begin, end;
+} Sweeper;
+
+#define SWEEPER_MAX 8
+#define SWEEP_THRESHOLD 512
+
 /**
  * @brief The Shader structure
  */
 typedef struct Shader {
   char* entityID;
+  Entity* entity;     // The entity drawn (NULL once released, until the queue drops the shader)
+  struct Shader* next;    // The next shader drawing the same entity
+  const char* vertFile;
+  const char* fragFile;
   GLuint program;
+  GLint location;     // Location of the position uniform
+  unsigned int uploaded;  // Entity version last uploaded to the program (UPLOAD_NONE if never)
   GLuint vao, vbo, ebo;
+  struct MultiDrawProgram* multiDraw;   // The shared program when drawn by multi-draw (NULL otherwise)
+  unsigned int slot;                    // The shader's geometry in the shared mesh buffers
 } Shader;
 
+#define UPLOAD_NONE 0xFFFFFFFFu
+
+/**
+ * @brief The RenderStats structure (counters for the last drawn frame)
+ */
+typedef struct RenderStats {
+  unsigned int drawCalls;         // The number of draw calls
+  unsigned int uploads;           // The number of entities whose data was uploaded
+  unsigned long long uploadBytes; // The number of bytes uploaded
+  unsigned int particles;         // The number of particles drawn
+  unsigned int glyphs;            // The number of glyphs drawn
+  unsigned int entities;          // The number of entities drawn
+  float hudTime;                  // The time the HUD took to update and draw (ms, 0 when hidden)
+} RenderStats;
+
+#define GARBAGE_FRAMES 3
+
+/**
+ * @brief The Garbage structure (GL objects waiting on a fence before deletion)
+ */
+typedef struct Garbage {
+  GLsync fence;
+  GLuint* programs;
+  GLuint* arrays;
+  GLuint* buffers;
+  unsigned int count, capacity;
+} Garbage;
+
+/**
+ * @brief The ShaderFile structure (a shader source file being watched)
+ */
+typedef struct ShaderFile {
+  char* path;     // The file path
+  char* source;   // The latest source (main thread only)
+  int watch;      // The watch descriptor of the file's directory
+} ShaderFile;
+
+/**
+ * @brief The ShaderReload structure (a changed source read by the watcher thread)
+ */
+typedef struct ShaderReload {
+  const char* path;
+  char* source;
+} ShaderReload;
+
+#define RECORDER_MAX 8
+#define RECORDER_THRESHOLD 512
+
+/**
+ * @brief The DrawCommand structure (everything needed to submit one draw)
+ */
+typedef struct DrawCommand {
+  GLuint program;
+  GLint location;     // The position uniform (the draw base uniform with multi-draw)
+  GLuint vao;
+  bool upload;        // Whether the position changed since the program last saw it
+  bool multiDraw;     // Whether the command goes through multi-draw-indirect
+  unsigned int slot;  // The geometry in the shared mesh buffers (multi-draw only)
+  float position[3];
+} DrawCommand;
+
+/**
+ * @brief The MultiDrawProgram structure (a program variant shared by every shader built from the same files)
+ *
+ * The vertex shader is rewritten for GL 4.5: its "uniform vec3 position" is
+ * replaced by a lookup into a storage buffer of positions, one per mesh
+ * slot, indexed by the slot each draw passes as its base instance.
+ */
+typedef struct MultiDrawProgram {
+  const char* vertFile;
+  const char* fragFile;
+  GLuint program;
+  unsigned int references;  // The number of shaders using it
+} MultiDrawProgram;
+
+/**
+ * @brief The IndirectCommand structure (the layout glMultiDrawElementsIndirect reads)
+ */
+typedef struct IndirectCommand {
+  GLuint count;
+  GLuint instanceCount;
+  GLuint firstIndex;
+  GLint baseVertex;
+  GLuint baseInstance;
+} IndirectCommand;
+
+/**
+ * @brief The StagedDraw structure (a multi-draw command waiting to be grouped by program)
+ */
+typedef struct StagedDraw {
+  const DrawCommand* command;
+  unsigned int order;       // Submission order (kept within a program)
+} StagedDraw;
+
+#define MESH_CAPACITY 256
+
+/**
+ * @brief The DrawList structure (commands recorded by one thread)
+ */
+typedef struct DrawList {
+  DrawCommand* commands;
+  unsigned int count, capacity;
+} DrawList;
+
+/**
+ * @brief The Recorder structure (a thread recording a slice of the shader queue)
+ */
+typedef struct Recorder {
+  SDL_Thread* thread;
+  SDL_sem* start;
+  SDL_sem* done;
+  DrawList* list;
+  unsigned int begin, end;
+} Recorder;
+
+/**
+ * @brief The Frame structure (an immutable snapshot of everything a frame draws)
+ */
+typedef struct Frame {
+  DrawList lists[RECORDER_MAX + 1];
+  unsigned int count;
+} Frame;
+
+#define TILEMAP_CHUNK 32
+
+/**
+ * @brief The Chunk structure (a TILEMAP_CHUNK square of tiles baked into one buffer)
+ */
+typedef struct Chunk {
+  GLuint vao, vbo;
+  unsigned int count;   // The number of baked vertices
+  bool dirty;           // Whether the tiles changed since the chunk was baked
+} Chunk;
+
+/**
+ * @brief The Tilemap structure
+ *
+ * Tiles are 16-bit ids (0 is empty). Every non-empty tile becomes two
+ * triangles whose vertices carry the position (location 0, like entities)
+ * and the tile id (location 1), offset by the "position" uniform.
+ */
+typedef struct Tilemap {
+  const char* vertFile;
+  const char* fragFile;
+  GLuint program;
+  GLint location;           // Location of the position uniform
+  int width, height;        // The size of the map in tiles
+  float tileWidth, tileHeight;
+  float position[3];        // The bottom-left corner of the map
+  unsigned short* tiles;
+  int columns, rows;        // The number of chunks across and down
+  Chunk* chunks;
+  SDL_SpinLock lock;        // Guards the tiles and dirty flags (written by any thread, baked on the render thread)
+} Tilemap;
+
+/**
+ * @brief The EmitterSettings structure (how an emitter spawns and moves its particles)
+ *
+ * Units match entity positions: clip space, per second.
+ */
+typedef struct EmitterSettings {
+  float rate;           // Particles spawned per second
+  float life;           // Lifetime of a particle (seconds, jittered down to 75%)
+  float velocity[2];    // Initial velocity
+  float spread;         // Random velocity added along each axis (up to +/- spread)
+  float gravity[2];     // Acceleration
+  float size;           // Point size (pixels)
+  bool gpu;             // Whether particles live and move on the GPU (fixed at creation)
+} EmitterSettings;
+
+/**
+ * @brief The Emitter structure
+ *
+ * CPU particles are stored as structure-of-arrays in one 64-byte aligned block
+ * so integration runs four particles at a time. Dead particles are swapped with
+ * the last live one, keeping the live particles packed at the front.
+ *
+ * GPU particles live in a ring of GPU_PARTICLE_FLOATS records ping-ponged
+ * between two buffers by transform feedback; new particles overwrite the
+ * oldest slots and dead ones are parked outside clip space until reused.
+ */
+typedef struct Emitter {
+  const char* vertFile;
+  const char* fragFile;
+  GLuint program;
+  GLint location;               // Location of the position uniform
+  GLuint vao, vbo;              // Streamed points: vec3 position (location 0), float age (location 1)
+  float position[3];
+  EmitterSettings settings;
+  float* block;                 // The arrays below, in one allocation
+  float *x, *y, *vx, *vy, *age, *life;
+  unsigned int count, capacity;
+  float pending;                // Fractional particles waiting to spawn
+  unsigned int burst;           // Particles to spawn at once on the next update
+  uint32_t seed;
+  GLuint states[2];             // The ping-pong particle buffers (GPU only)
+  GLuint updateArrays[2];       // Every record field of each buffer, for the update pass (GPU only)
+  GLuint drawArrays[2];         // Position (location 0) and age (location 1) of each buffer (GPU only)
+  unsigned int current;         // The buffer holding the latest state (GPU only)
+  unsigned int head;            // The next ring slot to spawn into (GPU only)
+  float remaining;              // The time until the newest particle dies (seconds, GPU only)
+} Emitter;
+
+#define GPU_PARTICLE_FLOATS 6   // x, y, vx, vy, age (0 to 1), 1 / life
+
+#define SCENE_VERSION 2
+#define SCENE_ALIGNMENT 64
+
+/**
+ * @brief The scene file header
+ *
+ * A scene is laid out as the header, the entities, the shader records and
+ * finally the NUL-terminated ids and filenames. The entities and records are
+ * each aligned to SCENE_ALIGNMENT. Entities are stored as images of the
+ * Entity structure, with the ID holding the offset of the id string and the
+ * parent holding the parent's index + 1, so a scene only loads into a build
+ * with the same Entity layout.
+ */
+typedef struct SceneHeader {
+  char magic[8];            // "NANISCEN"
+  uint32_t version;         // SCENE_VERSION
+  uint32_t entitySize;      // sizeof(Entity) when written
+  uint32_t entities;        // The number of entities
+  uint32_t shaders;         // The number of shader records
+  uint64_t entityOffset;    // The offset of the entities from the start of the file
+  uint64_t shaderOffset;    // The offset of the shader records
+  uint64_t stringOffset;    // The offset of the strings
+} SceneHeader;
+
+/**
+ * @brief A scene shader record
+ */
+typedef struct SceneShader {
+  uint32_t entity;          // The index of the entity it draws
+  uint32_t vertFile;        // The offset of the vertex shader filename
+  uint32_t fragFile;        // The offset of the fragment shader filename
+} SceneShader;
+
+/**
+ * @brief A loaded scene (the mapped file holds every id and filename its entities and shaders use)
+ */
+typedef struct Scene {
+  unsigned char* data;      // The mapped file
+  size_t size;              // The size of the file
+  bool mapped;              // Whether data is mapped (or read into memory)
+  Entity* entities;         // Every entity, in one block
+  unsigned int count;
+} Scene;
+
+/**
+ * @brief A linked program kept while a scene loads, so later shaders with the same files skip compiling
+ */
+typedef struct ProgramBinary {
+  const char* vertFile;
+  const char* fragFile;
+  GLenum format;
+  GLsizei length;
+  void* data;
+} ProgramBinary;
+
+/**
+ * @brief A pair of files rebuilt during one hot reload, so every program built from them compiles once
+ */
+typedef struct ProgramReload {
+  ProgramBinary binary;     // The linked program, copied into the later users (empty without binary support)
+  bool built;               // Whether the new sources compiled
+} ProgramReload;
+
+#define FONT_FIRST 32           // The first glyph of a font sheet (space)
+#define FONT_GLYPHS 96          // The glyphs of a font sheet (space to DEL)
+#define FONT_COLUMNS 16         // The glyphs in each row of a font sheet
+
+/**
+ * @brief The GlyphVertex structure (one corner of a glyph quad)
+ */
+typedef struct GlyphVertex {
+  float position[3];
+  float coordinates[2];         // Atlas coordinates
+  unsigned char color[4];
+} GlyphVertex;
+
+/**
+ * @brief The Font structure (a glyph atlas)
+ */
+typedef struct Font {
+  GLuint texture;               // Glyph coverage (one channel)
+  int width, height;            // Atlas size (pixels)
+  int cellWidth, cellHeight;    // Glyph size (pixels)
+  unsigned int first, count;    // The font's vertices in the text batch
+} Font;
+
+/**
+ * @brief The Text structure
+ *
+ * The glyphs are laid out relative to the position once per distinct string,
+ * so setting the same string again or moving the text never lays it out again.
+ */
+typedef struct Text {
+  Font* font;
+  char* string;
+  float position[3];            // The bottom-left corner of the first line
+  float size;                   // Glyph height (in the same units as entity dimensions)
+  unsigned char color[4];
+  GlyphVertex* vertices;        // Six per visible glyph
+  unsigned int count, capacity;
+} Text;
+
+#define HUD_FRAMES 120           // Frame times shown by the graph
+#define HUD_REFRESH 0.25         // Seconds between refreshes of the counters
+#define HUD_SIZE 0.5f            // Glyph height (in the same units as entity dimensions)
+#define HUD_GRAPH_WIDTH 0.6f     // Graph size (normalized device coordinates)
+#define HUD_GRAPH_HEIGHT 0.15f
+
+/**
+ * @brief The HUD structure (the performance overlay)
+ */
+typedef struct HUD {
+  SDL_atomic_t visible;
+  Font* font;                    // The built-in font (created when first shown)
+  char string[256];              // The counters
+  Text text;                     // The counters laid out (not in the text queue)
+  unsigned int lines;
+  float times[HUD_FRAMES];       // Frame times (ms), oldest at head
+  unsigned int head;
+  Uint64 last;                   // When the last frame was drawn (performance counter, 0 if hidden)
+  Uint64 refreshed;              // When the counters were last laid out
+  float cost;                    // The HUD's own time last frame (ms)
+  GLuint vao, vbo;
+  GlyphVertex* vertices;
+  unsigned int capacity;         // Vertices the buffer (and the scratch) can hold
+} HUD;
+
+#define RESOLUTION_MIN 0.5f      // The lowest render scale
+#define RESOLUTION_STEP 0.1f     // How much the render scale changes at a time
+#define RESOLUTION_DOWN 0.9f     // The share of the frame budget that scales down when exceeded
+#define RESOLUTION_UP 0.7f       // The share of the frame budget that scales up when undercut
+#define RESOLUTION_FRAMES 30     // The frames a condition must hold before scaling down (4x for up)
+#define TIMER_QUERIES 4
+
+/**
+ * @brief The Scaler structure (the scaled render target and the frame times driving it)
+ */
+typedef struct Scaler {
+  bool enabled;
+  float budget;                     // The frame budget (ms)
+  float scale;                      // The render target's share of the drawable, per axis
+  float gpuTime, cpuTime;           // Rolling averages of the scene's GPU and CPU time (ms)
+  int over, under;                  // Consecutive frames over and under the thresholds
+  GLuint framebuffer, color, depth;
+  int width, height;                // The render target size
+  int drawableWidth, drawableHeight;
+  GLuint queries[TIMER_QUERIES];
+  bool pending[TIMER_QUERIES];
+  unsigned int query;               // The next timer query
+  bool timing;                      // Whether the current frame is being timed
+  Uint64 start;                     // When the current frame started (performance counter)
+} Scaler;
+
+#define CAPTURE_BUFFERS 4
+#define STREAM_BUFFERS 6
+
+/**
+ * @brief The Stream structure (a frame sequence being written by the encoder thread)
+ *
+ * The file starts with the 8-byte magic "NANITEFS". Every frame follows as
+ * four little-endian 32-bit words (index, width, height, byte count) and its
+ * pixels: bottom-up RGBA rows, or the RLE encoding from compressFrame(). A
+ * zero width ends the stream (the unused tail of a preallocated file).
+ */
+typedef struct Stream {
+  char* path;                 // The file or named pipe
+  FILE* file;                 // Opened by the encoder thread on the first frame
+  unsigned int limit;         // The number of frames to preallocate and record (0 if unbounded)
+  bool compress;              // Whether frames are run-length encoded
+  unsigned char* scratch;     // The encoder's compression buffer
+  unsigned int scratchSize;
+  SDL_atomic_t failed;        // Set by the encoder once the file can't be opened or written
+} Stream;
+
+/**
+ * @brief The Capture structure (a pixel buffer object the backbuffer is read into)
+ */
+typedef struct Capture {
+  GLuint pbo;
+  GLsync fence;
+  char* filename;     // The BMP file the pixels go to
+  Stream* stream;     // The stream the pixels go to (the buffer is free if neither is set)
+  unsigned int index; // The frame's index in the stream
+  int width, height;
+  unsigned int size;  // The allocated size of the buffer
+} Capture;
+
+/**
+ * @brief The CaptureJob structure (captured pixels waiting to be encoded)
+ */
+typedef struct CaptureJob {
+  char* filename;     // The BMP file to write, NULL for a stream frame
+  BMP* image;         // The pixels, NULL to close the stream
+  Stream* stream;
+  unsigned int index;
+} CaptureJob;
+
 // Render field variables
-static Queue* shaders;              // Queue of living shaders
+static Queue* shaders;              // Queue of living shaders (and released ones until the next recording)
+static unsigned int deadShaders;    // The number of released shaders still in the queue
 static HashMap* entities;           // HashMap of living entities
+static Pack* mounted;               // Pack that shader sources are read from first
+static RenderStats stats;           // Counters for the last drawn frame
+static Scaler scaler = { .scale = 1.0f };   // Dynamic resolution (owned by the thread with the context)
+
+// Broadphase field variables
+static Proxy* proxies;                      // Every entity's bounds, sorted by min[0]
+static unsigned int proxyCount, proxyCapacity;
+static unsigned int proxiesAdded;           // Proxies appended since the last query
+static SDL_SpinLock broadphaseLock;         // Guards the proxies (entities may be destroyed on the render thread)
+static PairList pairLists[SWEEPER_MAX + 1]; // Slot 0 sweeps on the querying thread and holds the result
+static Sweeper sweepers[SWEEPER_MAX + 1];
+static unsigned int sweeperCount;           // Number of sweeper threads
+static SDL_atomic_t sweeping;               // Whether the sweeper threads should keep running
+
+// Transform hierarchy field variables
+static Entity** transforms;                 // Entities with a parent or children, parents first (breadth-first once sorted)
+static unsigned int transformCount, transformCapacity;
+static bool transformsSorted = true;        // Whether the order is breadth-first
+static unsigned int transformsFrom;         // The first dirty entity in the order
+static unsigned int transformPass;          // Counts the update passes
+
+// Multi-draw-indirect backend (GL 4.5, owned by the thread with the context)
+static bool multiDraw;                      // Whether the GL 4.5 backend is in use
+static Queue* multiDrawPrograms;            // Queue of shared multi-draw programs
+static GLuint meshArray;                    // Vertex array over the shared mesh buffers
+static GLuint meshVertices, meshIndices;    // Every multi-draw shader's geometry, a slot each
+static unsigned int meshSlots, meshCapacity;
+static Queue* meshFree;                     // Released slots (stored as slot + 1)
+static GLuint drawBuffer;                   // Per-frame indirect commands
+static GLuint positionBuffer;               // Every slot's position (persistent, written when it changes)
+static unsigned int drawCapacity;
+static StagedDraw* staged;
+static unsigned int stagedCount, stagedCapacity;
+static IndirectCommand* indirectCommands;
+static float* indirectPositions;            // The CPU copy of the position buffer (a vec4 per slot)
+static unsigned int* dirtySlots;            // The slots written this frame
+static Queue* tilemaps;             // Queue of living tilemaps (owned by the thread with the context)
+static float* bakery;               // Scratch vertices for baking a chunk
+static Queue* emitters;             // Queue of living emitters (owned by the thread with the context)
+static Uint64 particleClock;        // When the particles were last updated (performance counter)
+static GLuint particleProgram;      // The transform feedback program advancing GPU particles
+static GLint particleDelta, particleGravity;
+static Queue* fonts;                // Queue of living fonts (owned by the thread with the context)
+static Queue* texts;                // Queue of living texts (owned by the thread with the context)
+static bool textsChanged;           // Whether the text batch needs rebuilding
+static GLuint textProgram, textArray, textBuffer;
+static GlyphVertex* textBatch;      // Every text's glyphs, grouped by font
+static unsigned int textBatchCapacity, textBufferCapacity;
+static Queue* programBinaries;      // Programs linked while a scene loads (NULL otherwise)
+static HUD hud;                     // The performance overlay (drawn by the thread with the context)
+
+// Lazy rendering field variables
+static SDL_atomic_t redrawRequested;      // Whether something changed since the last frame
+static SDL_atomic_t redrawDeadline;       // SDL_GetTicks() when a timer wants a frame (0 for none)
+static SDL_atomic_t frameResumed;         // Whether the loop idled before this frame
+static Uint32 wakeEvent;                  // The event waking a sleeping lazy loop (0 until one sleeps)
+
+// Deferred deletion field variables
+static Garbage garbage[GARBAGE_FRAMES];   // Ring of per-frame garbage batches
+static unsigned int garbageFrame;         // Index of the batch collecting this frame
+
+// Hot-reload field variables (inotify is Linux only)
+#ifdef __linux__
+static FILE* watcher;                     // The inotify instance
+static SDL_Thread* watcherThread;         // The thread reading changed files
+static SDL_atomic_t watching;             // Whether the watcher thread should keep running
+static SDL_mutex* shaderFilesLock;        // Guards the watched file table
+static ShaderFile* shaderFiles;           // Table of watched files
+static unsigned int shaderFileCount, shaderFileCapacity;
+static SPSCQueue* reloads;                // Changed sources, watcher thread to main thread
+#endif
+
+// Draw recording field variables
+static Recorder recorders[RECORDER_MAX + 1];  // Slot 0 records on the main thread
+static unsigned int recorderCount;            // Number of recorder threads
+static SDL_atomic_t recording;                // Whether the recorder threads should keep running
+
+// Render thread field variables
+static Frame frames[2];                       // Double-buffered frame snapshots
+static unsigned int frameWrite, frameRead;    // The snapshots being recorded and drawn
+static SDL_atomic_t framesReady;              // Number of snapshots waiting to be drawn
+static SDL_sem* framesFree;                   // Counts snapshots free to record into
+static SDL_sem* renderWake;                   // Posted once per snapshot, call or stop request
+static SDL_Thread* renderThread;              // The thread owning the OpenGL context
+static SDL_threadID renderThreadID;           // The render thread's id
+static SDL_Window* renderWindow;              // The window the render thread draws to
+static SDL_GLContext renderContext;           // The OpenGL context the render thread owns
+static void (*renderTask)(void*);             // The call the render thread should run
+static void* renderTaskData;                  // The argument of that call
+static SDL_sem* renderTaskDone;               // Posted once the call has run
+
+// Capture field variables
+static Capture captures[CAPTURE_BUFFERS];     // Ring of pixel buffer objects
+static unsigned int captureNext;              // The next buffer to read into
+static Queue* captureRequests;                // Filenames waiting for a frame
+static SPSCQueue* captureJobs;                // Captured frames, render thread to encoder thread
+static SDL_Thread* encoderThread;             // The thread writing captured frames
+static SDL_sem* encoderWake;                  // Posted once per job or stop request
+static SDL_atomic_t encoding;                 // Whether the encoder thread should keep running
+
+// Stream field variables
+static Stream* stream;                        // The stream being recorded, NULL if none
+static unsigned int streamFrames;             // Frames read back for the stream
+static SDL_atomic_t streamDropped;            // Frames dropped because the encoder fell behind or failed
+static SDL_atomic_t streamPending;            // Stream frames read back but not yet written
 
 /**
  * @brief Creates a new entity and appends it
@@ -618,8 +2931,9 @@ static HashMap* entities;           // HashMap of living entities
  * @param ID A string containing the entity's id
  * @param dimentions The width and height of the entity
  * @param position The position of the entity on the screen
+ * @return true if the entity was created (false if its id's slot is taken)
  */
-void createEntity(char* ID, int dimensions[2], float position[3]);
+bool createEntity(char* ID, int dimensions[2], float position[3]);
 
 /**
  * @brief Get the pointer of an entity from it's ID
@@ -646,321 +2960,5571 @@ float* getEntityPosition(char* ID);
 void updateEntityPosition(char* ID, float delta[3]);
 
 /**
- * @brief Creates a new shader and enqueues it
+ * @brief Destroys an entity and every shader drawing it
  * 
- * @param entityID Entity id
- * @param vertFile Vertex shader filename
- * @param fragFile Fragment shader filename
+ * @param ID The entity ID
  */
-void createShader(char* entityID, const char* vertFile, const char* fragFile);
+void destroyEntity(char* ID);
 
 /**
- * @brief Initialize OpenGL
+ * @brief Destroys an entity (render call)
+ * 
+ * @param data The entity ID
  */
-void initialize(void);
+static void destroyEntityCall(void* data);
 
 /**
- * @brief Render the scene.
+ * @brief Attaches an entity to a parent, keeping its world position (a NULL parent detaches it)
  * 
- * @param window The window to render to.
+ * @param ID The entity ID
+ * @param parentID The parent's ID (NULL to detach)
+ * @return true if the entity was attached (or detached)
  */
-void render(SDL_Window* window);
+bool setEntityParent(char* ID, char* parentID);
 
-#endif // NANITE_RENDER_INCLUDE
+/**
+ * @brief Recomputes the world positions of the entities whose hierarchy moved
+ */
+void updateTransforms(void);
 
-#ifdef NANITE_RENDER_IMPLEMENTATION
+/**
+ * @brief Links an entity to a parent, keeping its local position
+ * 
+ * @param entity The entity (without a parent)
+ * @param parent The parent (not the entity or one of its descendants)
+ */
+static void attachEntity(Entity* entity, Entity* parent);
+
+/**
+ * @brief Unlinks an entity from its parent, keeping its world position
+ * 
+ * @param entity The entity (with a parent)
+ */
+static void detachEntity(Entity* entity);
+
+/**
+ * @brief Adds an entity to the transform order if it's joined a hierarchy, or removes it if it's left one
+ * 
+ * @param entity The entity
+ */
+static void placeTransform(Entity* entity);
+
+/**
+ * @brief Finds every pair of entities whose bounds overlap
+ * 
+ * @param count Set to the number of pairs
+ * @return The pairs, valid until the next call or until one of the entities is destroyed
+ */
+const EntityPair* getOverlaps(unsigned int* count);
+
+/**
+ * @brief Set how many threads getOverlaps() sweeps large scenes with
+ * 
+ * @param count The number of extra threads (0 to sweep on the calling thread only)
+ */
+void setBroadphaseThreads(unsigned int count);
+
+/**
+ * @brief Appends an entity's proxy to the broadphase
+ * 
+ * @param entity The entity
+ */
+static void addProxy(Entity* entity);
+
+/**
+ * @brief Sweeps a slice of the sorted proxies for overlapping pairs
+ * 
+ * @param list The pair list to append to
+ * @param begin The first proxy index
+ * @param end One past the last proxy index
+ */
+static void sweepProxies(PairList* list, unsigned int begin, unsigned int end);
+
+/**
+ * @brief Waits for slices to sweep (sweeper thread)
+ * 
+ * @param data The sweeper
+ * @return 0 when the sweeper stops
+ */
+static int sweepLoop(void* data);
+
+/**
+ * @brief Creates a shader (render call)
+ * 
+ * @param data The entity ID, vertex and fragment shader filenames
+ */
+static void createShaderCall(void* data);
+
+/**
+ * @brief Queues GL objects for deletion once the GPU is done with them
+ * 
+ * @param program The shader program (0 if none)
+ * @param vao The vertex array object (0 if none)
+ * @param vbo The vertex buffer object (0 if none)
+ * @param ebo The element buffer object (0 if none)
+ */
+static void collectGarbage(GLuint program, GLuint vao, GLuint vbo, GLuint ebo);
+
+/**
+ * @brief Queues a shader's GL objects for deletion, leaving it in the queue for compactShaders()
+ * 
+ * @param shader The shader to release
+ */
+static void releaseShader(Shader* shader);
+
+/**
+ * @brief Drops the released shaders from the shader queue in one pass, freeing them
+ */
+static void compactShaders(void);
+
+/**
+ * @brief Deletes a garbage batch once the GPU has passed its fence
+ * 
+ * @param batch The garbage batch
+ * @param wait Whether to block until the fence signals
+ */
+static void reclaimGarbage(Garbage* batch, bool wait);
+
+/**
+ * @brief Fences the current garbage batch and moves on to the next one
+ */
+static void fenceGarbage(void);
+
+/**
+ * @brief Creates a new shader and enqueues it
+ * 
+ * @param entityID Entity id
+ * @param vertFile Vertex shader filename
+ * @param fragFile Fragment shader filename
+ */
+void createShader(char* entityID, const char* vertFile, const char* fragFile);
+
+/**
+ * @brief Starts watching shader files, recompiling programs when they change (Linux only)
+ * 
+ * @return true if the watcher is running
+ */
+bool watchShaders(void);
+
+/**
+ * @brief Stops watching shader files
+ */
+void unwatchShaders(void);
+
+/**
+ * @brief Keeps a shader source for hot-reloading, watching its file
+ * 
+ * @param path The file path
+ * @param source The file contents (ownership is taken on success)
+ * @return true if the source is now owned by the watcher
+ */
+static bool trackShaderSource(const char* path, char* source);
+
+/**
+ * @brief Checks whether the watcher thread has handed over changed sources
+ * 
+ * @return true if reloadShaders() has work to do
+ */
+static bool reloadsPending(void);
+
+/**
+ * @brief Recompiles the programs of every changed shader file
+ */
+static void reloadShaders(void);
+
+/**
+ * @brief Records draw commands for a slice of the shader queue
+ * 
+ * @param list The draw list to record into
+ * @param begin The first shader index
+ * @param end One past the last shader index
+ */
+static void recordDrawList(DrawList* list, unsigned int begin, unsigned int end);
+
+/**
+ * @brief Records the draw commands of every shader, spread over the recorder threads
+ * 
+ * @param frame The frame to record into
+ */
+static void recordDrawLists(Frame* frame);
+
+/**
+ * @brief Submits recorded draw lists in order, skipping redundant state changes
+ * 
+ * @param frame The recorded frame
+ */
+static void submitDrawLists(Frame* frame);
+
+/**
+ * @brief Draws a recorded frame and swaps the buffers
+ * 
+ * @param window The window to render to
+ * @param frame The recorded frame
+ */
+static void drawFrame(SDL_Window* window, Frame* frame);
+
+/**
+ * @brief Runs a function on the thread owning the OpenGL context, waiting for it
+ * 
+ * @param task The function to run
+ * @param data The function's argument
+ */
+static void renderCall(void (*task)(void*), void* data);
+
+/**
+ * @brief Sets the swap interval (render call)
+ * 
+ * @param data The swap interval
+ */
+static void swapIntervalCall(void* data);
+
+/**
+ * @brief Moves the OpenGL context to a dedicated render thread
+ * 
+ * @param window The window to render to
+ * @param context The OpenGL context (current on the calling thread)
+ */
+void startRenderThread(SDL_Window* window, SDL_GLContext context);
+
+/**
+ * @brief Stops the render thread, making the OpenGL context current on the calling thread
+ */
+void stopRenderThread(void);
+
+/**
+ * @brief Records a frame snapshot and hands it to the render thread
+ */
+void publishFrame(void);
+
+/**
+ * @brief Asks a lazy loop for another frame (called by anything that changes what's drawn)
+ */
+void requestFrame(void);
+
+/**
+ * @brief Asks a lazy loop for a frame after a delay (for timers and animations)
+ * 
+ * @param delay The time until the frame (ms)
+ */
+void requestFrameAfter(unsigned int delay);
+
+/**
+ * @brief Gets how long a lazy loop can sleep before a frame is due
+ * 
+ * @return The time until the next frame (ms), 0 if one is due, -1 if nothing has asked for one
+ */
+int pendingFrame(void);
+
+/**
+ * @brief Sleeps until there's input to handle or a frame is due (lazy loops)
+ * 
+ * @return true if the loop should step and draw, false if it should keep waiting
+ */
+bool awaitFrame(void);
+
+/**
+ * @brief Clears the frame requests the frame about to be drawn satisfies
+ */
+static void takeFrameRequests(void);
+
+/**
+ * @brief Waits for slices to record (recorder thread)
+ * 
+ * @param data The recorder
+ * @return 0 when the recorder stops
+ */
+static int recordDrawLoop(void* data);
+
+/**
+ * @brief Captures the next rendered frame into a BMP file without stalling the pipeline
+ * 
+ * @param filename The BMP filename
+ */
+void captureFrame(const char* filename);
+
+/**
+ * @brief Starts streaming every rendered frame to a file or named pipe
+ * 
+ * @param path The file or named pipe
+ * @param frames The number of frames to record (0 for no limit), preallocated for files
+ * @param compress Whether to run-length encode frames on the encoder thread
+ */
+void startRecording(const char* path, unsigned int frames, bool compress);
+
+/**
+ * @brief Stops streaming frames, flushing those still in flight
+ */
+void stopRecording(void);
+
+/**
+ * @brief Get the number of frames dropped by the current or last recording
+ * 
+ * @return The number of dropped frames
+ */
+unsigned int droppedFrames(void);
+
+/**
+ * @brief Closes the current stream behind its pending frames (render call)
+ * 
+ * @param data Unused
+ */
+static void stopRecordingCall(void* data);
+
+/**
+ * @brief Reads the backbuffer into a free pixel buffer object, if a capture is requested
+ * 
+ * @param window The window being rendered to
+ */
+static void requestCaptures(SDL_Window* window);
+
+/**
+ * @brief Hands every capture whose fence has signaled to the encoder thread
+ * 
+ * @param wait Whether to block until every capture has signaled
+ */
+static void readCaptures(bool wait);
+
+/**
+ * @brief Creates a tilemap of empty tiles
+ * 
+ * @param width The width of the map in tiles
+ * @param height The height of the map in tiles
+ * @param tileSize The size of a tile (in the same units as entity dimensions)
+ * @param position The bottom-left corner of the map on the screen
+ * @param vertFile Vertex shader filename
+ * @param fragFile Fragment shader filename
+ * @return A pointer to the tilemap
+ */
+Tilemap* createTilemap(int width, int height, float tileSize, float position[3], const char* vertFile, const char* fragFile);
+
+/**
+ * @brief Sets a rectangle of tiles, rebaking only the chunks it touches (on the next frame)
+ * 
+ * @param map The tilemap
+ * @param x The column of the rectangle's bottom-left tile
+ * @param y The row of the rectangle's bottom-left tile
+ * @param width The width of the rectangle
+ * @param height The height of the rectangle
+ * @param tiles The tile ids, row by row from the bottom
+ */
+void setTiles(Tilemap* map, int x, int y, int width, int height, const unsigned short* tiles);
+
+/**
+ * @brief Sets a single tile
+ * 
+ * @param map The tilemap
+ * @param x The tile's column
+ * @param y The tile's row
+ * @param tile The tile id (0 for empty)
+ */
+void setTile(Tilemap* map, int x, int y, unsigned short tile);
+
+/**
+ * @brief Gets a single tile
+ * 
+ * @param map The tilemap
+ * @param x The tile's column
+ * @param y The tile's row
+ * @return The tile id (0 for empty or out of range)
+ */
+unsigned short getTile(Tilemap* map, int x, int y);
+
+/**
+ * @brief Moves a tilemap
+ * 
+ * @param map The tilemap
+ * @param delta The change in position
+ */
+void moveTilemap(Tilemap* map, float delta[3]);
+
+/**
+ * @brief Destroys a tilemap, releasing its chunks once the GPU is done with them
+ * 
+ * @param map The tilemap
+ */
+void destroyTilemap(Tilemap* map);
+
+/**
+ * @brief Draws the chunks of every tilemap that intersect the screen, baking dirty ones
+ * 
+ * @return The number of draw calls
+ */
+static unsigned int drawTilemaps(void);
+
+/**
+ * @brief Creates a particle emitter
+ * 
+ * @param capacity The most particles alive at once
+ * @param position Where particles spawn
+ * @param settings How particles spawn and move
+ * @param vertFile Vertex shader filename
+ * @param fragFile Fragment shader filename
+ * @return A pointer to the emitter
+ */
+Emitter* createEmitter(unsigned int capacity, float position[3], const EmitterSettings* settings, const char* vertFile, const char* fragFile);
+
+/**
+ * @brief Changes how an emitter spawns and moves its particles
+ * 
+ * @param emitter The emitter
+ * @param settings The new settings
+ */
+void configureEmitter(Emitter* emitter, const EmitterSettings* settings);
+
+/**
+ * @brief Moves where an emitter spawns particles (live particles stay put)
+ * 
+ * @param emitter The emitter
+ * @param delta The change in position
+ */
+void moveEmitter(Emitter* emitter, float delta[3]);
+
+/**
+ * @brief Spawns particles at once on the next update
+ * 
+ * @param emitter The emitter
+ * @param count The number of particles
+ */
+void burstEmitter(Emitter* emitter, unsigned int count);
+
+/**
+ * @brief Destroys an emitter and its particles
+ * 
+ * @param emitter The emitter
+ */
+void destroyEmitter(Emitter* emitter);
+
+/**
+ * @brief Advances every emitter and draws each with a single call
+ * 
+ * @return The number of draw calls
+ */
+static unsigned int drawEmitters(void);
+
+/**
+ * @brief Creates the ping-pong state buffers of a GPU emitter (and the shared update program)
+ * 
+ * @param emitter The emitter
+ */
+static void createParticleStates(Emitter* emitter);
+
+/**
+ * @brief Creates a font from a BMP font sheet, or the built-in 5x7 font
+ * 
+ * @param filename The font sheet (FONT_GLYPHS glyphs from space, FONT_COLUMNS to a row from the top-left), NULL for the built-in font
+ * @param cellWidth The width of a glyph in the sheet (pixels)
+ * @param cellHeight The height of a glyph in the sheet (pixels)
+ * @return A pointer to the font, NULL if the sheet couldn't be loaded
+ */
+Font* createFont(const char* filename, int cellWidth, int cellHeight);
+
+/**
+ * @brief Destroys a font and every text using it
+ * 
+ * @param font The font
+ */
+void destroyFont(Font* font);
+
+/**
+ * @brief Creates a text
+ * 
+ * @param font The font
+ * @param string The string (newlines start a new line)
+ * @param position The bottom-left corner of the first line
+ * @param size The glyph height (in the same units as entity dimensions)
+ * @param color The RGBA color (0 to 1), NULL for white
+ * @return A pointer to the text
+ */
+Text* createText(Font* font, const char* string, float position[3], float size, const float color[4]);
+
+/**
+ * @brief Changes a text's string (nothing happens if it's the same string)
+ * 
+ * @param text The text
+ * @param string The new string
+ */
+void setText(Text* text, const char* string);
+
+/**
+ * @brief Moves a text
+ * 
+ * @param text The text
+ * @param delta The change in position
+ */
+void moveText(Text* text, float delta[3]);
+
+/**
+ * @brief Destroys a text
+ * 
+ * @param text The text
+ */
+void destroyText(Text* text);
+
+/**
+ * @brief Draws every text with one call per font
+ * 
+ * @return The number of draw calls
+ */
+static unsigned int drawTexts(void);
+
+/**
+ * @brief Show or hide the performance HUD
+ * 
+ * @param visible Whether the HUD is drawn
+ */
+void setHUD(bool visible);
+
+/**
+ * @brief Toggle the performance HUD
+ */
+void toggleHUD(void);
+
+/**
+ * @brief Draws the performance HUD over the finished frame with a single call
+ */
+static void drawHUD(void);
+
+/**
+ * @brief Saves every entity and shader to a scene file
+ * 
+ * @param filename The scene filename
+ * @return true if the scene was written
+ */
+bool saveScene(const char* filename);
+
+/**
+ * @brief Loads a scene file, creating its entities and shaders
+ * 
+ * @param filename The scene filename
+ * @return A pointer to the scene, NULL if it couldn't be loaded
+ */
+Scene* loadScene(const char* filename);
+
+/**
+ * @brief Destroys a scene's remaining entities (and their shaders) and unmaps it
+ * 
+ * @param scene The scene
+ */
+void unloadScene(Scene* scene);
+
+/**
+ * @brief Mount a pack that createShader() reads sources from before the file system
+ * 
+ * @param pack The pack (NULL to unmount)
+ */
+void mountPack(Pack* pack);
+
+/**
+ * @brief Get the counters of the last drawn frame
+ * 
+ * @return The render stats
+ */
+RenderStats getRenderStats(void);
+
+/**
+ * @brief Render into a scaled target that adapts to the measured frame time, upscaled to the window
+ * 
+ * @param enabled Whether to scale the resolution
+ * @param fps The frame rate to hold
+ */
+void setDynamicResolution(bool enabled, int fps);
+
+/**
+ * @brief Get the current render scale
+ * 
+ * @return The render target's share of the window, per axis (1 without dynamic resolution)
+ */
+float getResolutionScale(void);
+
+/**
+ * @brief Check whether the GL 4.5 multi-draw-indirect backend is in use
+ * 
+ * @return true if draws are submitted with glMultiDrawElementsIndirect
+ */
+bool getMultiDraw(void);
+
+/**
+ * @brief Submits the staged multi-draw commands, one call per program
+ * 
+ * @return The number of draw calls
+ */
+static unsigned int submitMultiDraws(void);
+
+/**
+ * @brief Rewrites a vertex shader to read its position from the multi-draw storage buffer
+ * 
+ * @param source The vertex shader source (declaring "uniform vec3 position;")
+ * @return The rewritten source (freed with memFree()), NULL if the shader can't be rewritten
+ */
+static char* multiDrawSource(const char* source);
+
+/**
+ * @brief Releases a shader's reference to a shared multi-draw program
+ * 
+ * @param entry The shared program
+ */
+static void releaseMultiDrawProgram(MultiDrawProgram* entry);
+
+/**
+ * @brief Binds the render target for a frame, following the drawable size
+ * 
+ * @param window The window being rendered to
+ */
+static void beginScene(SDL_Window* window);
+
+/**
+ * @brief Upscales the render target to the backbuffer and adapts the render scale
+ */
+static void endScene(void);
+
+/**
+ * @brief Initialize OpenGL
+ */
+void initialize(void);
+
+/**
+ * @brief Release the render field variables
+ */
+void finalize(void);
+
+/**
+ * @brief Render the scene.
+ * 
+ * @param window The window to render to.
+ */
+void render(SDL_Window* window);
+
+#endif // NANITE_RENDER_INCLUDE
+
+#ifdef NANITE_RENDER_IMPLEMENTATION
+
+/**
+ * @brief Creates a new entity and enqueues it
+ * 
+ * @param ID A string containing the entity's id
+ * @param dimensions The width and height of the entity
+ * @param position The position of the entity on the screen
+ * @return true if the entity was created (false if its id's slot is taken)
+ */
+bool createEntity(char* ID, int dimensions[2], float position[3]) {
+  // Verify that the id and position exist
+  if (!ID || !dimensions || !position)
+    return false;
+
+  // Creates an Entity pointer
+  Entity* entity = (Entity*) memAlloc(sizeof(Entity));
+  trackMemory(MEMORY_ENTITIES, sizeof(Entity));
+
+  // Sets entity ID
+  entity -> ID = ID;
+
+  // Set entity dimensions
+  entity -> width = dimensions[0];
+  entity -> height = dimensions[1];
+
+  // Set entity position
+  entity -> position[0] = position[0];
+  entity -> position[1] = position[1];
+  entity -> position[2] = position[2];
+  entity -> version = 0;
+  entity -> scene = NULL;
+  entity -> shaders = NULL;
+
+  // Start outside any hierarchy (the local position is the position)
+  memcpy(entity -> local, entity -> position, sizeof(entity -> local));
+  entity -> parent = NULL;
+  entity -> children = entity -> node = entity -> depth = entity -> moved = 0;
+  entity -> dirty = false;
+
+  // Set entity verticies
+  entity -> vertices[0]  =  (entity -> width) * (1.0f / 20.0f) / 2;     // Top right vertex x-pos
+  entity -> vertices[1]  =  (entity -> height) * (1.0f / 15.0f) / 2;    // Top right vertex y-pos
+  entity -> vertices[3]  =  (entity -> width) * (1.0f / 20.0f) / 2;     // Bottom right vertex x-pos
+  entity -> vertices[4]  = -(entity -> height) * (1.0f / 15.0f) / 2;    // Bottom right vertex y-pos
+  entity -> vertices[6]  = -(entity -> width) * (1.0f / 20.0f) / 2;     // Bottom left vertex x-pos
+  entity -> vertices[7]  = -(entity -> height) * (1.0f / 15.0f) / 2;    // Bottom left vertex y-pos
+  entity -> vertices[9]  = -(entity -> width) * (1.0f / 20.0f) / 2;     // Top left vertex x-pos
+  entity -> vertices[10] =  (entity -> height) * (1.0f / 15.0f) / 2;    // Top left vertex y-pos
+
+  // Set entity indices
+  entity -> indices[0] = 0;
+  entity -> indices[1] = 1;
+  entity -> indices[2] = 3;
+  entity -> indices[3] = 1;
+  entity -> indices[4] = 2;
+  entity -> indices[5] = 3;
+
+  // Appends the entity into the entity map and the broadphase (an id whose slot is taken is refused)
+  insert(entities, ID, entity);
+  if (search(entities, ID) != entity) {
+    fprintf(stderr, "Error: Could not create entity \"%s\", its slot is taken by \"%s\".\n", ID, ((Entity*) search(entities, ID)) -> ID);
+    trackMemory(MEMORY_ENTITIES, -(long long) sizeof(Entity));
+    memFree(entity);
+    return false;
+  }
+  addProxy(entity);
+  requestFrame();
+  return true;
+}
+
+/**
+ * @brief Get the pointer of an entity from it's ID
+ * 
+ * @param ID An entity ID
+ * @return A pointer to the entity
+ */
+Entity* getEntity(char* ID) {
+  // Verifies the id exists
+  if (!ID)
+    return NULL;
+
+  // Search the hash map, making sure the entity in the slot isn't another id with the same hash
+  Entity* entity = search(entities, ID);
+  return entity && strcmp(entity -> ID, ID) == 0 ? entity : NULL;
+}
+
+/**
+ * @brief Get entity position
+ * 
+ * @param ID The entity ID
+ * @return An array containing the entity's coordinates
+ */
+float* getEntityPosition(char* ID) {
+  // Verifies the id exists
+  if (!ID)
+    return NULL;
+
+  // Get the entity from the hash map, if it exists
+  Entity* entity = getEntity(ID);
+  if (!entity)
+    return NULL;
+
+  // Return the entity's position (bringing a moved hierarchy up to date first)
+  updateTransforms();
+  return (float[3]) {entity -> position[0], entity -> position[1], entity -> position[2]};
+}
+
+/**
+ * @brief Update entity position
+ * 
+ * @param ID The entity ID
+ * @param delta The changed in position
+ */
+void updateEntityPosition(char* ID, float delta[3]) {
+  // Verify that the id and delta exist
+  if (!ID || !delta)
+    return;
+
+  // Get the entity from the hash map, if it exists
+  Entity* entity = getEntity(ID);
+  if (!entity)
+    return;
+
+  // Update the entity's position
+  entity -> local[0] += delta[0];
+  entity -> local[1] += delta[1];
+  entity -> local[2] += delta[2];
+  requestFrame();
+
+  // Entities in a hierarchy move on the next update, along with everything attached to them
+  if (entity -> node) {
+    entity -> dirty = true;
+    if (transformsSorted && entity -> node - 1 < transformsFrom)
+      transformsFrom = entity -> node - 1;
+    return;
+  }
+  memcpy(entity -> position, entity -> local, sizeof(entity -> position));
+  (entity -> version)++;
+}
+
+/**
+ * @brief Destroys an entity and every shader drawing it
+ * 
+ * @param ID The entity ID
+ */
+void destroyEntity(char* ID) {
+  // Verify that the id exists
+  if (!ID)
+    return;
+
+  // The garbage batches belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    renderCall(destroyEntityCall, ID);
+    return;
+  }
+
+  // Get the entity from the hash map, if it exists
+  Entity* entity = getEntity(ID);
+  if (!entity)
+    return;
+
+  // Release the entity's shaders (the queue drops them in one pass before the next recording)
+  Shader* shader = entity -> shaders;
+  while (shader) {
+    Shader* next = shader -> next;
+    releaseShader(shader);
+    shader = next;
+  }
+  entity -> shaders = NULL;
+
+  // Drop the entity's proxy (the next query removes it)
+  SDL_AtomicLock(&broadphaseLock);
+  proxies[entity -> proxy].entity = NULL;
+  SDL_AtomicUnlock(&broadphaseLock);
+
+  // Leave the children where they are on the screen, and take the entity out of its hierarchy
+  if (entity -> node) {
+    register unsigned int itr;
+    updateTransforms();
+    for (itr = transformCount; itr-- > 0 && entity -> children;)
+      if (transforms[itr] -> parent == entity)
+        detachEntity(transforms[itr]);
+    if (entity -> parent)
+      detachEntity(entity);
+  }
+
+  // Remove the entity from the hash map and free it (scene entities are freed with their scene)
+  delete(entities, ID);
+  requestFrame();
+  if (entity -> scene)
+    return;
+  trackMemory(MEMORY_ENTITIES, -(long long) sizeof(Entity));
+  memFree(entity);
+}
+
+/**
+ * @brief Destroys an entity (render call)
+ * 
+ * @param data The entity ID
+ */
+static void destroyEntityCall(void* data) {
+  destroyEntity((char*) data);
+}
+
+/**
+ * @brief Attaches an entity to a parent, keeping its world position (a NULL parent detaches it)
+ * 
+ * @param ID The entity ID
+ * @param parentID The parent's ID (NULL to detach)
+ * @return true if the entity was attached (or detached)
+ */
+bool setEntityParent(char* ID, char* parentID) {
+  // Get the entities from the hash map, if they exist
+  Entity* entity = ID ? getEntity(ID) : NULL;
+  Entity* parent = parentID ? getEntity(parentID) : NULL;
+  if (!entity || (parentID && !parent))
+    return false;
+
+  // Refuse to attach an entity below itself
+  Entity* ancestor;
+  for (ancestor = parent; ancestor; ancestor = ancestor -> parent)
+    if (ancestor == entity)
+      return false;
+
+  // Detach it from its current parent where it is now
+  updateTransforms();
+  if (entity -> parent)
+    detachEntity(entity);
+  if (!parent)
+    return true;
+
+  // Attach it, keeping the world position by offsetting it from the parent's
+  entity -> local[0] = entity -> position[0] - parent -> position[0];
+  entity -> local[1] = entity -> position[1] - parent -> position[1];
+  entity -> local[2] = entity -> position[2] - parent -> position[2];
+  attachEntity(entity, parent);
+  return true;
+}
+
+/**
+ * @brief Links an entity to a parent, keeping its local position
+ * 
+ * @param entity The entity (without a parent)
+ * @param parent The parent (not the entity or one of its descendants)
+ */
+static void attachEntity(Entity* entity, Entity* parent) {
+  entity -> parent = parent;
+  (parent -> children)++;
+  placeTransform(entity);
+  placeTransform(parent);
+  transformsSorted = false;
+
+  // Compute its world position on the next update
+  entity -> dirty = true;
+  requestFrame();
+}
+
+/**
+ * @brief Unlinks an entity from its parent, keeping its world position
+ * 
+ * @param entity The entity (with a parent)
+ */
+static void detachEntity(Entity* entity) {
+  Entity* parent = entity -> parent;
+  entity -> parent = NULL;
+  (parent -> children)--;
+  memcpy(entity -> local, entity -> position, sizeof(entity -> local));
+  placeTransform(entity);
+  placeTransform(parent);
+  transformsSorted = false;
+}
+
+/**
+ * @brief Adds an entity to the transform order if it's joined a hierarchy, or removes it if it's left one
+ * 
+ * @param entity The entity
+ */
+static void placeTransform(Entity* entity) {
+  bool joined = entity -> parent || entity -> children;
+  if (joined == (entity -> node != 0))
+    return;
+
+  // Append it (the next update sorts it into place)
+  if (joined) {
+    if (transformCount == transformCapacity) {
+      unsigned int capacity = transformCapacity ? transformCapacity << 1 : 64;
+      Entity** grown = (Entity**) memRealloc(transforms, sizeof(Entity*) * capacity);
+      if (!grown)
+        error("Failed to grow transforms!");
+      trackMemory(MEMORY_ENTITIES, (long long) sizeof(Entity*) * (capacity - transformCapacity));
+      transforms = grown;
+      transformCapacity = capacity;
+    }
+    transforms[transformCount++] = entity;
+    entity -> node = transformCount;
+  }
+
+  // Or swap the last entity into its place
+  else {
+    Entity* last = transforms[--transformCount];
+    transforms[entity -> node - 1] = last;
+    last -> node = entity -> node;
+    entity -> node = 0;
+    entity -> dirty = false;
+  }
+  transformsSorted = false;
+}
+
+/**
+ * @brief Orders two entities by their depth in a hierarchy
+ * 
+ * @param a The first entity
+ * @param b The second entity
+ * @return Negative, zero or positive as a is shallower, as deep or deeper than b
+ */
+static int compareDepths(const void* a, const void* b) {
+  unsigned int first = (*(Entity* const*) a) -> depth, second = (*(Entity* const*) b) -> depth;
+  return (first > second) - (first < second);
+}
+
+/**
+ * @brief Recomputes the world positions of the entities whose hierarchy moved
+ */
+void updateTransforms(void) {
+  register unsigned int itr;
+
+  // Sort the order breadth-first after a hierarchy changed shape
+  if (!transformsSorted) {
+    for (itr = 0; itr < transformCount; itr++) {
+      Entity* ancestor = transforms[itr] -> parent;
+      unsigned int depth = 0;
+      for (; ancestor; ancestor = ancestor -> parent)
+        depth++;
+      transforms[itr] -> depth = depth;
+    }
+    qsort(transforms, transformCount, sizeof(Entity*), compareDepths);
+    for (itr = 0; itr < transformCount; itr++)
+      transforms[itr] -> node = itr + 1;
+    transformsSorted = true;
+    transformsFrom = 0;
+  }
+
+  // Verify that something moved
+  if (transformsFrom >= transformCount)
+    return;
+
+  // Move the dirty entities and, as parents come first, everything below them in one pass
+  transformPass++;
+  for (itr = transformsFrom; itr < transformCount; itr++) {
+    Entity* entity = transforms[itr];
+    Entity* parent = entity -> parent;
+    if (!(entity -> dirty) && !(parent && parent -> moved == transformPass))
+      continue;
+
+    entity -> position[0] = parent ? parent -> position[0] + entity -> local[0] : entity -> local[0];
+    entity -> position[1] = parent ? parent -> position[1] + entity -> local[1] : entity -> local[1];
+    entity -> position[2] = parent ? parent -> position[2] + entity -> local[2] : entity -> local[2];
+    entity -> dirty = false;
+    entity -> moved = transformPass;
+    (entity -> version)++;
+  }
+  transformsFrom = transformCount;
+}
+
+/**
+ * @brief Appends an entity's proxy to the broadphase
+ * 
+ * @param entity The entity
+ */
+static void addProxy(Entity* entity) {
+  SDL_AtomicLock(&broadphaseLock);
+
+  // Grow the proxies if they're full
+  if (proxyCount == proxyCapacity) {
+    unsigned int capacity = proxyCapacity ? proxyCapacity << 1 : 64;
+    Proxy* grown = (Proxy*) memRealloc(proxies, sizeof(Proxy) * capacity);
+    if (!grown)
+      error("Failed to grow broadphase!");
+    trackMemory(MEMORY_ENTITIES, (long long) sizeof(Proxy) * (capacity - proxyCapacity));
+    proxies = grown;
+    proxyCapacity = capacity;
+  }
+
+  // Append it unsorted (its bounds are filled in by the next query)
+  entity -> proxy = proxyCount;
+  proxies[proxyCount++].entity = entity;
+  proxiesAdded++;
+
+  SDL_AtomicUnlock(&broadphaseLock);
+}
+
+/**
+ * @brief Orders two proxies by their lower x bound
+ * 
+ * @param a The first proxy
+ * @param b The second proxy
+ * @return Negative, zero or positive like strcmp()
+ */
+static int compareProxies(const void* a, const void* b) {
+  float x = ((const Proxy*) a) -> min[0], y = ((const Proxy*) b) -> min[0];
+  return (x > y) - (x < y);
+}
+
+/**
+ * @brief Sweeps a slice of the sorted proxies for overlapping pairs
+ * 
+ * @param list The pair list to append to
+ * @param begin The first proxy index
+ * @param end One past the last proxy index
+ */
+static void sweepProxies(PairList* list, unsigned int begin, unsigned int end) {
+  list -> count = 0;
+  register unsigned int itr, other;
+  for (itr = begin; itr < end; itr++) {
+    const Proxy* proxy = &proxies[itr];
+
+    // Only the proxies starting before this one ends can overlap it on x
+    for (other = itr + 1; other < proxyCount && proxies[other].min[0] < proxy -> max[0]; other++) {
+      if (proxies[other].min[1] >= proxy -> max[1] || proxy -> min[1] >= proxies[other].max[1])
+        continue;
+
+      // Grow the list if it's full
+      if (list -> count == list -> capacity) {
+        unsigned int capacity = list -> capacity ? (list -> capacity) << 1 : 64;
+        EntityPair* pairs = (EntityPair*) memRealloc(list -> pairs, sizeof(EntityPair) * capacity);
+        if (!pairs)
+          error("Failed to grow overlap pairs!");
+        list -> pairs = pairs;
+        list -> capacity = capacity;
+      }
+      list -> pairs[list -> count].a = proxy -> entity;
+      list -> pairs[(list -> count)++].b = proxies[other].entity;
+    }
+  }
+}
+
+/**
+ * @brief Waits for slices to sweep (sweeper thread)
+ * 
+ * @param data The sweeper
+ * @return 0 when the sweeper stops
+ */
+static int sweepLoop(void* data) {
+  Sweeper* sweeper = (Sweeper*) data;
+  while (true) {
+    SDL_SemWait(sweeper -> start);
+    if (!SDL_AtomicGet(&sweeping))
+      break;
+    sweepProxies(sweeper -> list, sweeper -> begin, sweeper -> end);
+    SDL_SemPost(sweeper -> done);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Finds every pair of entities whose bounds overlap
+ * 
+ * Entities move little between frames, so the proxies stay nearly sorted and
+ * an insertion sort puts them back in order in close to linear time. Only
+ * when many entities were created since the last query is a full sort used.
+ * 
+ * @param count Set to the number of pairs
+ * @return The pairs, valid until the next call or until one of the entities is destroyed
+ */
+const EntityPair* getOverlaps(unsigned int* count) {
+  updateTransforms();
+  SDL_AtomicLock(&broadphaseLock);
+
+  // Drop the destroyed entities' proxies and refresh the others' bounds from their quads
+  register unsigned int itr, other;
+  unsigned int size = 0;
+  for (itr = 0; itr < proxyCount; itr++) {
+    Entity* entity = proxies[itr].entity;
+    if (!entity)
+      continue;
+    Proxy* proxy = &proxies[size++];
+    proxy -> entity = entity;
+    proxy -> min[0] = entity -> position[0] - entity -> vertices[0];
+    proxy -> min[1] = entity -> position[1] - entity -> vertices[1];
+    proxy -> max[0] = entity -> position[0] + entity -> vertices[0];
+    proxy -> max[1] = entity -> position[1] + entity -> vertices[1];
+  }
+  proxyCount = size;
+
+  // Restore the order, sorting from scratch if too many proxies were appended
+  if (proxiesAdded > 64 && proxiesAdded > proxyCount / 8)
+    qsort(proxies, proxyCount, sizeof(Proxy), compareProxies);
+  else {
+    for (itr = 1; itr < proxyCount; itr++) {
+      if (proxies[itr - 1].min[0] <= proxies[itr].min[0])
+        continue;
+      Proxy proxy = proxies[itr];
+      for (other = itr; other > 0 && proxies[other - 1].min[0] > proxy.min[0]; other--)
+        proxies[other] = proxies[other - 1];
+      proxies[other] = proxy;
+    }
+  }
+  proxiesAdded = 0;
+  for (itr = 0; itr < proxyCount; itr++)
+    proxies[itr].entity -> proxy = itr;
+
+  // Only use as many threads as there are full slices of work
+  unsigned int threads = proxyCount / SWEEP_THRESHOLD;
+  if (threads > sweeperCount)
+    threads = sweeperCount;
+
+  // Hand a contiguous slice to every thread, keeping the first for this one
+  unsigned int slices = threads + 1;
+  for (itr = 0; itr < slices; itr++) {
+    sweepers[itr].list = &pairLists[itr];
+    sweepers[itr].begin = (unsigned int) (((unsigned long long) proxyCount * itr) / slices);
+    sweepers[itr].end = (unsigned int) (((unsigned long long) proxyCount * (itr + 1)) / slices);
+  }
+  for (itr = 1; itr < slices; itr++)
+    SDL_SemPost(sweepers[itr].start);
+  sweepProxies(&pairLists[0], sweepers[0].begin, sweepers[0].end);
+  for (itr = 1; itr < slices; itr++)
+    SDL_SemWait(sweepers[itr].done);
+
+  // Gather the other threads' pairs behind the first's
+  PairList* result = &pairLists[0];
+  for (itr = 1; itr < slices; itr++) {
+    PairList* list = &pairLists[itr];
+    if (result -> count + list -> count > result -> capacity) {
+      EntityPair* pairs = (EntityPair*) memRealloc(result -> pairs, sizeof(EntityPair) * (result -> count + list -> count));
+      if (!pairs)
+        error("Failed to grow overlap pairs!");
+      result -> pairs = pairs;
+      result -> capacity = result -> count + list -> count;
+    }
+    memcpy(result -> pairs + result -> count, list -> pairs, sizeof(EntityPair) * list -> count);
+    result -> count += list -> count;
+  }
+
+  SDL_AtomicUnlock(&broadphaseLock);
+  if (count)
+    *count = result -> count;
+  return result -> pairs;
+}
+
+/**
+ * @brief Set how many threads getOverlaps() sweeps large scenes with
+ * 
+ * @param count The number of extra threads (0 to sweep on the calling thread only)
+ */
+void setBroadphaseThreads(unsigned int count) {
+  // Stop the running sweepers
+  SDL_AtomicSet(&sweeping, 0);
+  register unsigned int itr;
+  for (itr = 1; itr <= sweeperCount; itr++) {
+    SDL_SemPost(sweepers[itr].start);
+    SDL_WaitThread(sweepers[itr].thread, NULL);
+    SDL_DestroySemaphore(sweepers[itr].start);
+    SDL_DestroySemaphore(sweepers[itr].done);
+  }
+  memset(sweepers, 0, sizeof(sweepers));
+
+  // Start the new ones
+  sweeperCount = count < SWEEPER_MAX ? count : SWEEPER_MAX;
+  SDL_AtomicSet(&sweeping, 1);
+  for (itr = 1; itr <= sweeperCount; itr++) {
+    sweepers[itr].start = SDL_CreateSemaphore(0);
+    sweepers[itr].done = SDL_CreateSemaphore(0);
+    sweepers[itr].thread = SDL_CreateThread(sweepLoop, "nanite-sweeper", &sweepers[itr]);
+    if (!sweepers[itr].thread)
+      error("Failed to create sweeper thread!");
+  }
+}
+
+/**
+ * @brief Creates a shader (render call)
+ * 
+ * @param data The entity ID, vertex and fragment shader filenames
+ */
+static void createShaderCall(void* data) {
+  void** args = (void**) data;
+  createShader((char*) args[0], (const char*) args[1], (const char*) args[2]);
+}
+
+/**
+ * @brief Queues GL objects for deletion once the GPU is done with them
+ * 
+ * @param program The shader program (0 if none)
+ * @param vao The vertex array object (0 if none)
+ * @param vbo The vertex buffer object (0 if none)
+ * @param ebo The element buffer object (0 if none)
+ */
+static void collectGarbage(GLuint program, GLuint vao, GLuint vbo, GLuint ebo) {
+  Garbage* batch = &garbage[garbageFrame];
+
+  // Grow the batch if it's full
+  if (batch -> count == batch -> capacity) {
+    unsigned int capacity = batch -> capacity ? (batch -> capacity) << 1 : 16;
+    GLuint* programs = (GLuint*) memRealloc(batch -> programs, sizeof(GLuint) * capacity);
+    if (programs)
+      batch -> programs = programs;
+    GLuint* arrays = (GLuint*) memRealloc(batch -> arrays, sizeof(GLuint) * capacity);
+    if (arrays)
+      batch -> arrays = arrays;
+    GLuint* buffers = (GLuint*) memRealloc(batch -> buffers, sizeof(GLuint) * capacity * 2);
+    if (buffers)
+      batch -> buffers = buffers;
+    if (!programs || !arrays || !buffers)
+      error("Failed to grow garbage batch!");
+    batch -> capacity = capacity;
+  }
+
+  // Record the GL objects (GL silently ignores the 0 names)
+  batch -> programs[batch -> count] = program;
+  batch -> arrays[batch -> count] = vao;
+  batch -> buffers[(batch -> count) * 2] = vbo;
+  batch -> buffers[(batch -> count) * 2 + 1] = ebo;
+  (batch -> count)++;
+}
+
+/**
+ * @brief Queues a shader's GL objects for deletion and frees the shader
+ * 
+ * @param shader The shader to release
+ */
+static void releaseShader(Shader* shader) {
+  // Give back the shared geometry and program
+  if (shader -> multiDraw) {
+    enqueue(meshFree, (void*) (uintptr_t) (shader -> slot + 1));
+    releaseMultiDrawProgram(shader -> multiDraw);
+    shader -> multiDraw = NULL;
+  }
+
+  // The GL objects are deleted once the GPU is done with them
+  collectGarbage(shader -> program, shader -> vao, shader -> vbo, shader -> ebo);
+  shader -> program = shader -> vao = shader -> vbo = shader -> ebo = 0;
+
+  // Mark it released; the queue drops it before the next recording
+  shader -> entity = NULL;
+  shader -> next = NULL;
+  deadShaders++;
+}
+
+/**
+ * @brief Drops the released shaders from the shader queue in one pass, freeing them
+ */
+static void compactShaders(void) {
+  register unsigned int itr, count = queueSize(shaders);
+  for (itr = 0; itr < count; itr++) {
+    Shader* shader = dequeue(shaders);
+    if (shader -> entity)
+      enqueue(shaders, shader);
+    else {
+      trackMemory(MEMORY_SHADERS, -(long long) sizeof(Shader));
+      memFree(shader);
+    }
+  }
+  deadShaders = 0;
+}
+
+/**
+ * @brief Deletes a garbage batch once the GPU has passed its fence
+ * 
+ * @param batch The garbage batch
+ * @param wait Whether to block until the fence signals
+ */
+static void reclaimGarbage(Garbage* batch, bool wait) {
+  // Verify that the batch has been fenced
+  if (!(batch -> fence))
+    return;
+
+  // Check (or wait for) the fence
+  GLenum status = wait
+    ? glClientWaitSync(batch -> fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED)
+    : glClientWaitSync(batch -> fence, 0, 0);
+  if (status == GL_TIMEOUT_EXPIRED)
+    return;
+  glDeleteSync(batch -> fence);
+  batch -> fence = 0;
+
+  // Release the buffers from the accounting (their sizes are only known to GL)
+  register unsigned int itr;
+  GLint size;
+  for (itr = 0; itr < (batch -> count) * 2; itr++) {
+    if (!(batch -> buffers[itr]))
+      continue;
+    glBindBuffer(GL_COPY_READ_BUFFER, batch -> buffers[itr]);
+    glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+    trackMemory(MEMORY_GL_BUFFERS, -(long long) size);
+  }
+  glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+  // Delete the whole batch with as few calls as possible
+  for (itr = 0; itr < batch -> count; itr++)
+    glDeleteProgram(batch -> programs[itr]);
+  glDeleteVertexArrays(batch -> count, batch -> arrays);
+  glDeleteBuffers((batch -> count) * 2, batch -> buffers);
+  batch -> count = 0;
+}
+
+/**
+ * @brief Fences the current garbage batch and moves on to the next one
+ */
+static void fenceGarbage(void) {
+  // Fence the batch behind this frame's commands
+  Garbage* batch = &garbage[garbageFrame];
+  if (batch -> count == 0)
+    return;
+  batch -> fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  // Move to the next batch, waiting on it if the GPU is that far behind
+  garbageFrame = (garbageFrame + 1) % GARBAGE_FRAMES;
+  reclaimGarbage(&garbage[garbageFrame], true);
+}
+
+/**
+ * @brief Compiles a single shader stage
+ * 
+ * @param type The shader type
+ * @param source The shader source
+ * @return The shader if successful, 0 if it isn't
+ */
+static GLuint compileStage(GLenum type, const char* source) {
+  // Create the shader.
+  GLuint stage = glCreateShader(type);
+  if (stage == 0)
+    return 0;
+
+  // Compile the shader.
+  glShaderSource(stage, 1, &source, NULL);
+  glCompileShader(stage);
+
+  // Verify the compilation, printing the info log on failure.
+  GLint status;
+  glGetShaderiv(stage, GL_COMPILE_STATUS, &status);
+  if (status != GL_TRUE) {
+    char log[512];
+    glGetShaderInfoLog(stage, sizeof(log), NULL, log);
+    fprintf(stderr, "Error: Could not compile %s shader.\n%s", type == GL_VERTEX_SHADER ? "vertex" : "fragment", log);
+    glDeleteShader(stage);
+    return 0;
+  }
+
+  return stage;
+}
+
+/**
+ * @brief Compiles and links a shader program
+ * 
+ * @param vertSource Vertex shader source
+ * @param fragSource Fragment shader source
+ * @return The shader program if successful, 0 if it isn't
+ */
+static GLuint compileProgram(const char* vertSource, const char* fragSource) {
+  // Compile the vertex shader.
+  GLuint vertShader = compileStage(GL_VERTEX_SHADER, vertSource);
+  if (vertShader == 0)
+    return 0;
+
+  // Compile the fragment shader.
+  GLuint fragShader = compileStage(GL_FRAGMENT_SHADER, fragSource);
+  if (fragShader == 0) {
+    glDeleteShader(vertShader);
+    return 0;
+  }
+
+  // Create the shader program.
+  GLuint program = glCreateProgram();
+  if (program != 0) {
+    // Attach the shaders and link the shader program.
+    glAttachShader(program, vertShader);
+    glAttachShader(program, fragShader);
+    glLinkProgram(program);
+
+    // Verify the link, printing the info log on failure.
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status != GL_TRUE) {
+      char log[512];
+      glGetProgramInfoLog(program, sizeof(log), NULL, log);
+      fprintf(stderr, "Error: Could not link shader program.\n%s", log);
+      glDeleteProgram(program);
+      program = 0;
+    }
+  }
+
+  // Delete the shaders (the program keeps them alive).
+  glDeleteShader(vertShader);
+  glDeleteShader(fragShader);
+
+  return program;
+}
+
+#ifdef __linux__
+
+/**
+ * @brief Find a watched shader file by path (main thread)
+ * 
+ * @param path The file path
+ * @return A pointer to the shader file, NULL if it isn't watched
+ */
+static ShaderFile* findShaderFile(const char* path) {
+  register unsigned int itr;
+  for (itr = 0; itr < shaderFileCount; itr++)
+    if (strcmp(shaderFiles[itr].path, path) == 0)
+      return &shaderFiles[itr];
+
+  return NULL;
+}
+
+/**
+ * @brief Keeps a shader source for hot-reloading, watching its file
+ * 
+ * @param path The file path
+ * @param source The file contents (ownership is taken on success)
+ * @return true if the source is now owned by the watcher
+ */
+static bool trackShaderSource(const char* path, char* source) {
+  // Verify that the watcher is running
+  if (!watcher)
+    return false;
+
+  // Replace the source of a file that's already watched
+  ShaderFile* file = findShaderFile(path);
+  if (file) {
+    memFree(file -> source);
+    file -> source = source;
+    return true;
+  }
+
+  // Watch the file's directory (editors often replace files by renaming)
+  char* directory = memStrdup(path);
+  char* slash = strrchr(directory, '/');
+  if (slash)
+    *slash = '\0';
+  int watch = inotify_add_watch(fileno(watcher), slash ? directory : ".", IN_CLOSE_WRITE | IN_MOVED_TO);
+  memFree(directory);
+  if (watch < 0) {
+    fprintf(stderr, "Error: Could not watch \"%s\".\n", path);
+    return false;
+  }
+
+  // Append the file, holding the lock since the watcher thread reads the table
+  SDL_LockMutex(shaderFilesLock);
+  if (shaderFileCount == shaderFileCapacity) {
+    unsigned int capacity = shaderFileCapacity ? shaderFileCapacity << 1 : 8;
+    ShaderFile* files = (ShaderFile*) memRealloc(shaderFiles, sizeof(ShaderFile) * capacity);
+    if (!files) {
+      SDL_UnlockMutex(shaderFilesLock);
+      return false;
+    }
+    shaderFiles = files;
+    shaderFileCapacity = capacity;
+  }
+  shaderFiles[shaderFileCount++] = (ShaderFile) { memStrdup(path), source, watch };
+  SDL_UnlockMutex(shaderFilesLock);
+
+  return true;
+}
+
+/**
+ * @brief Waits for shader file changes and reads the new sources (watcher thread)
+ * 
+ * @param data Unused
+ * @return 0 when the watcher stops
+ */
+static int watchShaderFiles(void* data) {
+  (void) data;
+  char buffer[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  struct pollfd descriptor = { fileno(watcher), POLLIN, 0 };
+
+  while (SDL_AtomicGet(&watching)) {
+    // Wake up periodically to notice unwatchShaders()
+    if (poll(&descriptor, 1, 100) <= 0)
+      continue;
+
+    // Read a batch of events
+    struct iovec vector = { buffer, sizeof(buffer) };
+    ssize_t length = readv(descriptor.fd, &vector, 1);
+    if (length <= 0)
+      continue;
+
+    char* itr = buffer;
+    while (itr < buffer + length) {
+      struct inotify_event* event = (struct inotify_event*) itr;
+      itr += sizeof(struct inotify_event) + event -> len;
+      if (event -> len == 0)
+        continue;
+
+      // Find the watched file the event refers to (paths live until the thread stops)
+      const char* path = NULL;
+      SDL_LockMutex(shaderFilesLock);
+      register unsigned int index;
+      for (index = 0; index < shaderFileCount && !path; index++) {
+        const char* name = strrchr(shaderFiles[index].path, '/');
+        if (shaderFiles[index].watch == event -> wd && strcmp(name ? name + 1 : shaderFiles[index].path, event -> name) == 0)
+          path = shaderFiles[index].path;
+      }
+      SDL_UnlockMutex(shaderFilesLock);
+      if (!path)
+        continue;
+
+      // Read the source here so the main thread only has to compile
+      char* source = readfile(path);
+      if (!source)
+        continue;
+
+      // Hand the source to the main thread
+      ShaderReload* reload = (ShaderReload*) memAlloc(sizeof(ShaderReload));
+      reload -> path = path;
+      reload -> source = source;
+      while (!spscEnqueue(reloads, reload) && SDL_AtomicGet(&watching))
+        SDL_Delay(1);
+      requestFrame();
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Starts watching shader files, recompiling programs when they change
+ * 
+ * @return true if the watcher is running
+ */
+bool watchShaders(void) {
+  // Verify that the watcher isn't already running
+  if (watcher)
+    return true;
+
+  // Create the inotify instance, held as a stream so that it can be closed
+  // without <unistd.h> (whose close() collides with the window API)
+  int descriptor = inotify_init1(IN_CLOEXEC);
+  if (descriptor < 0)
+    return false;
+  watcher = fdopen(descriptor, "r");
+  if (!watcher)
+    return false;
+
+  // Initialize the watcher field variables
+  shaderFilesLock = SDL_CreateMutex();
+  reloads = createSPSCQueue(64);
+  SDL_AtomicSet(&watching, 1);
+
+  // Watch the files of every living shader
+  QueueIterator itr = iterateQueue(shaders);
+  Shader* shader;
+  while ((shader = nextElement(&itr))) {
+    const char* files[2] = { shader -> vertFile, shader -> fragFile };
+    register int index;
+    for (index = 0; index < 2; index++) {
+      if (findShaderFile(files[index]))
+        continue;
+      char* source = readfile(files[index]);
+      if (source && !trackShaderSource(files[index], source))
+        memFree(source);
+    }
+  }
+
+  // Start the watcher thread
+  watcherThread = SDL_CreateThread(watchShaderFiles, "nanite-watcher", NULL);
+  if (!watcherThread) {
+    unwatchShaders();
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Stops watching shader files
+ */
+void unwatchShaders(void) {
+  // Verify that the watcher is running
+  if (!watcher)
+    return;
+
+  // Stop the watcher thread
+  SDL_AtomicSet(&watching, 0);
+  if (watcherThread)
+    SDL_WaitThread(watcherThread, NULL);
+  watcherThread = NULL;
+
+  // Free the pending reloads
+  ShaderReload* reload;
+  while ((reload = spscDequeue(reloads))) {
+    memFree(reload -> source);
+    memFree(reload);
+  }
+  freeSPSCQueue(reloads);
+  reloads = NULL;
+
+  // Free the watched files
+  register unsigned int itr;
+  for (itr = 0; itr < shaderFileCount; itr++) {
+    memFree(shaderFiles[itr].path);
+    memFree(shaderFiles[itr].source);
+  }
+  memFree(shaderFiles);
+  shaderFiles = NULL;
+  shaderFileCount = shaderFileCapacity = 0;
+  SDL_DestroyMutex(shaderFilesLock);
+  shaderFilesLock = NULL;
+
+  // Close the inotify instance
+  fclose(watcher);
+  watcher = NULL;
+}
+
+/**
+ * @brief Checks whether the watcher thread has handed over changed sources
+ * 
+ * @return true if reloadShaders() has work to do
+ */
+static bool reloadsPending(void) {
+  return reloads && SDL_AtomicGet(&(reloads -> front)) != SDL_AtomicGet(&(reloads -> rear));
+}
+
+/**
+ * @brief Builds a new program from a pair of changed files, compiling the pair only for its first user
+ * 
+ * @param rebuilt The pairs rebuilt so far in this reload
+ * @param path The changed file
+ * @param vertFile The program's vertex shader filename
+ * @param fragFile The program's fragment shader filename
+ * @return The new program, 0 if the new sources don't build
+ */
+static GLuint rebuildProgram(Queue* rebuilt, const char* path, const char* vertFile, const char* fragFile) {
+  ShaderFile* vert = findShaderFile(vertFile);
+  ShaderFile* frag = findShaderFile(fragFile);
+  if (!vert || !frag)
+    return 0;
+
+  // Copy the program if the pair has already been rebuilt
+  QueueIterator itr = iterateQueue(rebuilt);
+  ProgramReload* entry;
+  while ((entry = nextElement(&itr))) {
+    if (strcmp(entry -> binary.vertFile, vertFile) != 0 || strcmp(entry -> binary.fragFile, fragFile) != 0)
+      continue;
+    if (!(entry -> built))
+      return 0;
+    if (entry -> binary.data) {
+      GLuint program = glCreateProgram();
+      glProgramBinary(program, entry -> binary.format, entry -> binary.data, entry -> binary.length);
+      GLint status;
+      glGetProgramiv(program, GL_LINK_STATUS, &status);
+      if (status == GL_TRUE)
+        return program;
+      glDeleteProgram(program);
+    }
+
+    // Without binary support the pair is compiled again
+    return compileProgram(vert -> source, frag -> source);
+  }
+
+  // Compile the pair, keeping the linked program for its other users
+  entry = (ProgramReload*) memCalloc(1, sizeof(ProgramReload));
+  if (!entry)
+    error("Failed to allocate shader reload!");
+  entry -> binary.vertFile = vertFile;
+  entry -> binary.fragFile = fragFile;
+  GLuint program = compileProgram(vert -> source, frag -> source);
+  entry -> built = program != 0;
+  if (program && GLEW_ARB_get_program_binary) {
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &(entry -> binary.length));
+    entry -> binary.data = entry -> binary.length > 0 ? memAlloc((size_t) entry -> binary.length) : NULL;
+    if (entry -> binary.data)
+      glGetProgramBinary(program, entry -> binary.length, NULL, &(entry -> binary.format), entry -> binary.data);
+  }
+  if (!(entry -> built))
+    fprintf(stderr, "Error: Could not reload \"%s\", keeping the previous programs built from \"%s\" and \"%s\".\n", path, vertFile, fragFile);
+  enqueue(rebuilt, entry);
+  return program;
+}
+
+/**
+ * @brief Recompiles a program if it's built from a changed file, keeping it if the new source doesn't build
+ * 
+ * @param rebuilt The pairs rebuilt so far in this reload
+ * @param path The changed file
+ * @param vertFile The program's vertex shader filename
+ * @param fragFile The program's fragment shader filename
+ * @param program The program (swapped when rebuilt)
+ * @param location The position uniform's location (updated when rebuilt)
+ * @return true if the program was rebuilt
+ */
+static bool reloadProgram(Queue* rebuilt, const char* path, const char* vertFile, const char* fragFile, GLuint* program, GLint* location) {
+  if (strcmp(vertFile, path) != 0 && strcmp(fragFile, path) != 0)
+    return false;
+
+  GLuint built = rebuildProgram(rebuilt, path, vertFile, fragFile);
+  if (built == 0)
+    return false;
+
+  collectGarbage(*program, 0, 0, 0);
+  *program = built;
+  *location = glGetUniformLocation(built, "position");
+  return true;
+}
+
+/**
+ * @brief Recompiles the programs of every changed shader file (main thread)
+ */
+static void reloadShaders(void) {
+  // Verify that the watcher is running
+  if (!reloads)
+    return;
+
+  ShaderReload* reload;
+  while ((reload = spscDequeue(reloads))) {
+    Uint64 start = SDL_GetPerformanceCounter();
+
+    // Swap in the new source
+    ShaderFile* file = findShaderFile(reload -> path);
+    memFree(file -> source);
+    file -> source = reload -> source;
+
+    // Recompile every program built from the file (each pair of files compiles once)
+    unsigned int count = 0;
+    Queue* rebuilt = createQueue();
+    QueueIterator itr = iterateQueue(shaders);
+    Shader* shader;
+    while ((shader = nextElement(&itr))) {
+      if (!(shader -> entity) || shader -> multiDraw)
+        continue;
+      if (!reloadProgram(rebuilt, file -> path, shader -> vertFile, shader -> fragFile, &(shader -> program), &(shader -> location)))
+        continue;
+      shader -> uploaded = UPLOAD_NONE;
+      count++;
+    }
+
+    // And every shared multi-draw program
+    QueueIterator shared = iterateQueue(multiDrawPrograms);
+    MultiDrawProgram* entry;
+    while ((entry = nextElement(&shared))) {
+      if (strcmp(entry -> vertFile, file -> path) != 0 && strcmp(entry -> fragFile, file -> path) != 0)
+        continue;
+
+      ShaderFile* vert = findShaderFile(entry -> vertFile);
+      ShaderFile* frag = findShaderFile(entry -> fragFile);
+      char* rewritten = vert && frag ? multiDrawSource(vert -> source) : NULL;
+      GLuint program = rewritten ? compileProgram(rewritten, frag -> source) : 0;
+      memFree(rewritten);
+      if (program == 0) {
+        fprintf(stderr, "Error: Could not reload \"%s\", keeping the previous program.\n", file -> path);
+        continue;
+      }
+
+      collectGarbage(entry -> program, 0, 0, 0);
+      entry -> program = program;
+      count++;
+    }
+
+    // And every tilemap and emitter program built from it
+    QueueIterator maps = iterateQueue(tilemaps);
+    Tilemap* map;
+    while ((map = nextElement(&maps)))
+      count += reloadProgram(rebuilt, file -> path, map -> vertFile, map -> fragFile, &(map -> program), &(map -> location));
+    QueueIterator sources = iterateQueue(emitters);
+    Emitter* emitter;
+    while ((emitter = nextElement(&sources)))
+      count += reloadProgram(rebuilt, file -> path, emitter -> vertFile, emitter -> fragFile, &(emitter -> program), &(emitter -> location));
+
+    // Drop the rebuilt pairs
+    ProgramReload* pair;
+    while ((pair = dequeue(rebuilt))) {
+      memFree(pair -> binary.data);
+      memFree(pair);
+    }
+    freeQueue(rebuilt);
+
+    if (count)
+      printf("\x1b[5m\x1B[32mReloaded\x1B[0m: \"%s\" (%u programs, %.2f ms)\n", file -> path, count,
+        (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+    memFree(reload);
+  }
+}
+
+#else
+
+static bool trackShaderSource(const char* path, char* source) {
+  (void) path;
+  (void) source;
+  return false;
+}
+bool watchShaders(void) { return false; }
+void unwatchShaders(void) {}
+static bool reloadsPending(void) { return false; }
+static void reloadShaders(void) {}
+
+#endif // __linux__
+
+/**
+ * @brief Mount a pack that createShader() reads sources from before the file system
+ * 
+ * @param pack The pack (NULL to unmount)
+ */
+void mountPack(Pack* pack) {
+  mounted = pack;
+}
+
+/**
+ * @brief Rewrites a vertex shader to read its position from the multi-draw storage buffer
+ * 
+ * @param source The vertex shader source (declaring "uniform vec3 position;")
+ * @return The rewritten source (freed with memFree()), NULL if the shader can't be rewritten
+ */
+static char* multiDrawSource(const char* source) {
+  static const char* declaration = "uniform vec3 position;";
+  static const char* prelude =
+    "#version 450 core\n"
+    "#extension GL_ARB_shader_draw_parameters : require\n"
+    "layout (std430, binding = 0) readonly buffer NanitePositions { vec4 nanitePositions[]; };\n"
+    "#define position (nanitePositions[gl_BaseInstanceARB].xyz)\n"
+    "#line 2\n";
+
+  // Find the version line and the position uniform
+  const char* body = strchr(source, '\n');
+  const char* uniform = strstr(source, declaration);
+  if (strncmp(source, "#version", 8) != 0 || !body || !uniform || uniform < body)
+    return NULL;
+  body++;
+
+  // Swap the version line for the prelude and drop the uniform
+  size_t preludeLength = strlen(prelude), headLength = uniform - body;
+  const char* tail = uniform + strlen(declaration);
+  char* rewritten = (char*) memAlloc(preludeLength + headLength + strlen(tail) + 1);
+  if (!rewritten)
+    return NULL;
+  memcpy(rewritten, prelude, preludeLength);
+  memcpy(rewritten + preludeLength, body, headLength);
+  strcpy(rewritten + preludeLength + headLength, tail);
+  return rewritten;
+}
+
+/**
+ * @brief Loads, compiles and links a shader program from its files
+ * 
+ * @param vertFile Vertex shader filename
+ * @param fragFile Fragment shader filename
+ * @param variant Whether to build the multi-draw variant (returning 0 rather than failing)
+ * @return The shader program
+ */
+static GLuint loadProgram(const char* vertFile, const char* fragFile, bool variant) {
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  // Reuse a program linked earlier in this scene load
+  if (programBinaries && !variant) {
+    QueueIterator itr = iterateQueue(programBinaries);
+    ProgramBinary* binary;
+    while ((binary = nextElement(&itr))) {
+      if (strcmp(binary -> vertFile, vertFile) != 0 || strcmp(binary -> fragFile, fragFile) != 0)
+        continue;
+      GLuint program = glCreateProgram();
+      glProgramBinary(program, binary -> format, binary -> data, binary -> length);
+      GLint status;
+      glGetProgramiv(program, GL_LINK_STATUS, &status);
+      if (status == GL_TRUE) {
+        recordLoadMetrics(LOAD_SHADER, start);
+        return program;
+      }
+      glDeleteProgram(program);
+      break;
+    }
+  }
+
+  // Load the vertex shader (from the mounted pack, if it has it).
+  Asset vertAsset, fragAsset;
+  bool vertPacked = findAsset(mounted, vertFile, &vertAsset);
+  char* vertSource = vertPacked ? (char*) vertAsset.data : readfile(vertFile);
+  if (vertSource == NULL)
+    error("Failed to read vertex shader file!");
+
+  // Load the fragment shader (from the mounted pack, if it has it).
+  bool fragPacked = findAsset(mounted, fragFile, &fragAsset);
+  char* fragSource = fragPacked ? (char*) fragAsset.data : readfile(fragFile);
+  if (fragSource == NULL)
+    error("Failed to read fragment shader file!");
+
+  // Compile and link the shader program (or its multi-draw variant).
+  GLuint program = 0;
+  if (variant) {
+    char* rewritten = multiDrawSource(vertSource);
+    if (rewritten)
+      program = compileProgram(rewritten, fragSource);
+    memFree(rewritten);
+  }
+  else if ((program = compileProgram(vertSource, fragSource)) == 0)
+    error("Failed to create shader program!");
+
+  // Keep the linked program for the rest of a scene load.
+  if (programBinaries && !variant) {
+    ProgramBinary* binary = (ProgramBinary*) memCalloc(1, sizeof(ProgramBinary));
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &(binary -> length));
+    binary -> data = binary -> length > 0 ? memAlloc((size_t) binary -> length) : NULL;
+    if (binary -> data) {
+      glGetProgramBinary(program, binary -> length, NULL, &(binary -> format), binary -> data);
+      binary -> vertFile = vertFile;
+      binary -> fragFile = fragFile;
+      enqueue(programBinaries, binary);
+    }
+    else
+      memFree(binary);
+  }
+
+  // Keep the sources if the files are being watched (packed sources are views).
+  if (!vertPacked && !trackShaderSource(vertFile, vertSource))
+    memFree(vertSource);
+  if (!fragPacked && !trackShaderSource(fragFile, fragSource))
+    memFree(fragSource);
+
+  recordLoadMetrics(LOAD_SHADER, start);
+  return program;
+}
+
+/**
+ * @brief Gets (or builds) the multi-draw program shared by every shader built from the same files
+ * 
+ * @param vertFile Vertex shader filename
+ * @param fragFile Fragment shader filename
+ * @return The shared program, NULL if the shader can't be drawn by multi-draw
+ */
+static MultiDrawProgram* acquireMultiDrawProgram(const char* vertFile, const char* fragFile) {
+  // Reuse the program if it's already been built
+  QueueIterator itr = iterateQueue(multiDrawPrograms);
+  MultiDrawProgram* entry;
+  while ((entry = nextElement(&itr))) {
+    if (strcmp(entry -> vertFile, vertFile) == 0 && strcmp(entry -> fragFile, fragFile) == 0) {
+      entry -> references++;
+      return entry;
+    }
+  }
+
+  // Build the variant (shaders that can't be rewritten stay on the per-entity path)
+  GLuint program = loadProgram(vertFile, fragFile, true);
+  if (program == 0)
+    return NULL;
+
+  entry = (MultiDrawProgram*) memAlloc(sizeof(MultiDrawProgram));
+  trackMemory(MEMORY_SHADERS, sizeof(MultiDrawProgram));
+  entry -> vertFile = vertFile;
+  entry -> fragFile = fragFile;
+  entry -> program = program;
+  entry -> references = 1;
+  enqueue(multiDrawPrograms, entry);
+  return entry;
+}
+
+/**
+ * @brief Releases a shader's reference to a shared multi-draw program
+ * 
+ * @param entry The shared program
+ */
+static void releaseMultiDrawProgram(MultiDrawProgram* entry) {
+  if (--(entry -> references) > 0)
+    return;
+
+  // Drop the last reference from the queue
+  register unsigned int itr, count = queueSize(multiDrawPrograms);
+  for (itr = 0; itr < count; itr++) {
+    MultiDrawProgram* other = dequeue(multiDrawPrograms);
+    if (other != entry)
+      enqueue(multiDrawPrograms, other);
+  }
+
+  collectGarbage(entry -> program, 0, 0, 0);
+  trackMemory(MEMORY_SHADERS, -(long long) sizeof(MultiDrawProgram));
+  memFree(entry);
+}
+
+/**
+ * @brief Creates (or grows) the shared mesh and position buffers, keeping their contents
+ * 
+ * @param capacity The number of slots
+ */
+static void growMeshBuffers(unsigned int capacity) {
+  // Create the new buffers
+  GLuint vertices, indices, positions;
+  glCreateBuffers(1, &vertices);
+  glCreateBuffers(1, &indices);
+  glCreateBuffers(1, &positions);
+  glNamedBufferData(vertices, sizeof(float[12]) * capacity, NULL, GL_STATIC_DRAW);
+  glNamedBufferData(indices, sizeof(unsigned int[6]) * capacity, NULL, GL_STATIC_DRAW);
+  glNamedBufferData(positions, sizeof(float[4]) * capacity, NULL, GL_DYNAMIC_DRAW);
+  float* shadow = (float*) memAlignedAlloc(sizeof(float[4]) * capacity, 64);
+  if (!shadow)
+    error("Failed to grow multi-draw positions!");
+  trackMemory(MEMORY_GL_BUFFERS, (long long) (sizeof(float[12]) + sizeof(unsigned int[6]) + sizeof(float[4])) * capacity);
+  trackMemory(MEMORY_SHADERS, (long long) sizeof(float[4]) * capacity);
+
+  // Copy the old slots over, then release the old buffers once the GPU is done with them
+  if (meshVertices) {
+    glCopyNamedBufferSubData(meshVertices, vertices, 0, 0, sizeof(float[12]) * meshCapacity);
+    glCopyNamedBufferSubData(meshIndices, indices, 0, 0, sizeof(unsigned int[6]) * meshCapacity);
+    glCopyNamedBufferSubData(positionBuffer, positions, 0, 0, sizeof(float[4]) * meshCapacity);
+    memcpy(shadow, indirectPositions, sizeof(float[4]) * meshCapacity);
+    collectGarbage(0, 0, meshVertices, meshIndices);
+    collectGarbage(0, 0, positionBuffer, 0);
+  }
+  if (indirectPositions)
+    trackMemory(MEMORY_SHADERS, -(long long) (sizeof(float[4]) * meshCapacity));
+  memAlignedFree(indirectPositions, 64);
+  meshVertices = vertices;
+  meshIndices = indices;
+  positionBuffer = positions;
+  indirectPositions = shadow;
+  meshCapacity = capacity;
+
+  // Point the vertex array at them (a vec3 at location 0, like the per-entity path)
+  if (!meshArray) {
+    glCreateVertexArrays(1, &meshArray);
+    glEnableVertexArrayAttrib(meshArray, 0);
+    glVertexArrayAttribFormat(meshArray, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    glVertexArrayAttribBinding(meshArray, 0, 0);
+  }
+  glVertexArrayVertexBuffer(meshArray, 0, meshVertices, 0, 3 * sizeof(float));
+  glVertexArrayElementBuffer(meshArray, meshIndices);
+}
+
+/**
+ * @brief Copies an entity's geometry into a slot of the shared mesh buffers
+ * 
+ * @param vertices The entity's vertices
+ * @param indices The entity's indices
+ * @return The slot
+ */
+static unsigned int allocateMeshSlot(const float vertices[12], const unsigned int indices[6]) {
+  // Reuse a released slot, or take a new one (growing the buffers if they're full)
+  unsigned int slot;
+  if (!isEmpty(meshFree))
+    slot = (unsigned int) (uintptr_t) dequeue(meshFree) - 1;
+  else {
+    if (meshSlots == meshCapacity)
+      growMeshBuffers(meshCapacity ? meshCapacity << 1 : MESH_CAPACITY);
+    slot = meshSlots++;
+  }
+
+  glNamedBufferSubData(meshVertices, sizeof(float[12]) * slot, sizeof(float[12]), vertices);
+  glNamedBufferSubData(meshIndices, sizeof(unsigned int[6]) * slot, sizeof(unsigned int[6]), indices);
+  return slot;
+}
+
+/**
+ * @brief Check whether the GL 4.5 multi-draw-indirect backend is in use
+ * 
+ * @return true if draws are submitted with glMultiDrawElementsIndirect
+ */
+bool getMultiDraw(void) {
+  return multiDraw;
+}
+
+/**
+ * @brief Creates a new shader and enqueues it
+ * 
+ * @param entityID Entity id
+ * @param vertFile Vertex shader filename
+ * @param fragFile Fragment shader filename
+ */
+void createShader(char* entityID, const char* vertFile, const char* fragFile) {
+  // Verify that the entity and filenames exist
+  if (!entityID || !vertFile || !fragFile)
+    return;
+
+  // GL objects can only be created on the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    void* args[3] = { entityID, (void*) vertFile, (void*) fragFile };
+    renderCall(createShaderCall, args);
+    return;
+  }
+
+  // Verify that the entity exists
+  Entity* entity = getEntity(entityID);
+  if (!entity)
+    return;
+
+  // Create the shader, linking it to the entity
+  Shader* shader = (Shader*) memAlloc(sizeof(Shader));
+  if (!shader)
+    error("Failed to allocate shader!");
+  trackMemory(MEMORY_SHADERS, sizeof(Shader));
+  shader -> entityID = entityID;
+  shader -> entity = entity;
+  shader -> next = entity -> shaders;
+  entity -> shaders = shader;
+  shader -> vertFile = vertFile;
+  shader -> fragFile = fragFile;
+  shader -> uploaded = UPLOAD_NONE;
+  shader -> multiDraw = NULL;
+  shader -> slot = 0;
+
+  // Share geometry and program with every other shader when drawn by multi-draw
+  if (multiDraw && (shader -> multiDraw = acquireMultiDrawProgram(vertFile, fragFile))) {
+    shader -> slot = allocateMeshSlot(entity -> vertices, entity -> indices);
+    shader -> program = 0;
+    shader -> location = -1;
+    shader -> vao = shader -> vbo = shader -> ebo = 0;
+    enqueue(shaders, shader);
+    requestFrame();
+    return;
+  }
+
+  // Create the vertex array object.
+  glGenVertexArrays(1, &(shader -> vao));
+  if (shader -> vao == 0)
+    error("Failed to create vertex array object!");
+
+  // Create the vertex buffer object.
+  glGenBuffers(1, &(shader -> vbo));
+  if (shader -> vbo == 0)
+    error("Failed to create vertex buffer object!");
+
+  // Create the element buffer object.
+  glGenBuffers(1, &(shader -> ebo));
+  if (shader -> ebo == 0)
+    error("Failed to create element buffer object!");
+
+  // Bind the vertex array object.
+  glBindVertexArray(shader -> vao);
+
+  // Bind the vertex buffer object.
+  glBindBuffer(GL_ARRAY_BUFFER, shader -> vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(entity -> vertices), entity -> vertices, GL_DYNAMIC_DRAW);
+  trackMemory(MEMORY_GL_BUFFERS, sizeof(entity -> vertices));
+  if (glGetError() != GL_NO_ERROR)
+    error("Failed to bind vertex buffer object!");
+
+  // Bind the element buffer object.
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shader -> ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(entity -> indices), entity -> indices, GL_DYNAMIC_DRAW);
+  trackMemory(MEMORY_GL_BUFFERS, sizeof(entity -> indices));
+  if (glGetError() != GL_NO_ERROR)
+    error("Failed to bind element buffer object!");
+
+  // Set the vertex attribute pointers.
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+  glEnableVertexAttribArray(0);
+
+  // Load the shader program.
+  shader -> program = loadProgram(vertFile, fragFile, false);
+  shader -> location = glGetUniformLocation(shader -> program, "position");
+
+  // Add shader to queue
+  enqueue(shaders, shader);
+  requestFrame();
+}
+
+/**
+ * @brief Creates a tilemap (render call)
+ * 
+ * @param data The arguments of createTilemap() and a pointer to its result
+ */
+static void createTilemapCall(void* data) {
+  void** args = (void**) data;
+  *(Tilemap**) args[6] = createTilemap(*(int*) args[0], *(int*) args[1], *(float*) args[2], (float*) args[3], (const char*) args[4], (const char*) args[5]);
+}
+
+/**
+ * @brief Creates a tilemap of empty tiles
+ * 
+ * @param width The width of the map in tiles
+ * @param height The height of the map in tiles
+ * @param tileSize The size of a tile (in the same units as entity dimensions)
+ * @param position The bottom-left corner of the map on the screen
+ * @param vertFile Vertex shader filename
+ * @param fragFile Fragment shader filename
+ * @return A pointer to the tilemap
+ */
+Tilemap* createTilemap(int width, int height, float tileSize, float position[3], const char* vertFile, const char* fragFile) {
+  // Verify the dimensions, position and filenames
+  if (width <= 0 || height <= 0 || !position || !vertFile || !fragFile)
+    return NULL;
+
+  // Tilemaps belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    Tilemap* map = NULL;
+    void* args[7] = { &width, &height, &tileSize, position, (void*) vertFile, (void*) fragFile, &map };
+    renderCall(createTilemapCall, args);
+    return map;
+  }
+
+  // Create the tilemap
+  Tilemap* map = (Tilemap*) memCalloc(1, sizeof(Tilemap));
+  if (!map)
+    error("Failed to allocate tilemap!");
+  map -> vertFile = vertFile;
+  map -> fragFile = fragFile;
+  map -> width = width;
+  map -> height = height;
+  map -> tileWidth = tileSize * (1.0f / 20.0f);     // Same scale as entity vertices
+  map -> tileHeight = tileSize * (1.0f / 15.0f);
+  memcpy(map -> position, position, sizeof(map -> position));
+  map -> tiles = (unsigned short*) memCalloc((size_t) width * height, sizeof(unsigned short));
+
+  // Create the chunks (baked the first time they're on screen)
+  map -> columns = (width + TILEMAP_CHUNK - 1) / TILEMAP_CHUNK;
+  map -> rows = (height + TILEMAP_CHUNK - 1) / TILEMAP_CHUNK;
+  map -> chunks = (Chunk*) memCalloc((size_t) (map -> columns) * (map -> rows), sizeof(Chunk));
+  if (!(map -> tiles) || !(map -> chunks))
+    error("Failed to allocate tilemap!");
+  trackMemory(MEMORY_TILEMAPS, sizeof(Tilemap) + sizeof(unsigned short) * width * height + sizeof(Chunk) * (map -> columns) * (map -> rows));
+
+  // Load the shader program
+  map -> program = loadProgram(vertFile, fragFile, false);
+  map -> location = glGetUniformLocation(map -> program, "position");
+
+  enqueue(tilemaps, map);
+  requestFrame();
+  return map;
+}
+
+/**
+ * @brief Sets a rectangle of tiles, rebaking only the chunks it touches (on the next frame)
+ * 
+ * @param map The tilemap
+ * @param x The column of the rectangle's bottom-left tile
+ * @param y The row of the rectangle's bottom-left tile
+ * @param width The width of the rectangle
+ * @param height The height of the rectangle
+ * @param tiles The tile ids, row by row from the bottom
+ */
+void setTiles(Tilemap* map, int x, int y, int width, int height, const unsigned short* tiles) {
+  // Verify the map and tiles
+  if (!map || !tiles || width <= 0 || height <= 0)
+    return;
+
+  // Copy the tiles that fall inside the map (the render thread only bakes them)
+  register int row, col;
+  SDL_AtomicLock(&(map -> lock));
+  for (row = 0; row < height; row++) {
+    if (y + row < 0 || y + row >= map -> height)
+      continue;
+    for (col = 0; col < width; col++) {
+      if (x + col < 0 || x + col >= map -> width)
+        continue;
+      map -> tiles[(size_t) (y + row) * (map -> width) + (x + col)] = tiles[(size_t) row * width + col];
+    }
+  }
+
+  // Mark the chunks touched by the rectangle
+  int left = (x < 0 ? 0 : x) / TILEMAP_CHUNK, right = (x + width - 1 >= map -> width ? map -> width - 1 : x + width - 1) / TILEMAP_CHUNK;
+  int bottom = (y < 0 ? 0 : y) / TILEMAP_CHUNK, top = (y + height - 1 >= map -> height ? map -> height - 1 : y + height - 1) / TILEMAP_CHUNK;
+  for (row = bottom; row <= top; row++)
+    for (col = left; col <= right; col++)
+      map -> chunks[row * (map -> columns) + col].dirty = true;
+  SDL_AtomicUnlock(&(map -> lock));
+  requestFrame();
+}
+
+/**
+ * @brief Sets a single tile
+ * 
+ * @param map The tilemap
+ * @param x The tile's column
+ * @param y The tile's row
+ * @param tile The tile id (0 for empty)
+ */
+void setTile(Tilemap* map, int x, int y, unsigned short tile) {
+  setTiles(map, x, y, 1, 1, &tile);
+}
+
+/**
+ * @brief Gets a single tile
+ * 
+ * @param map The tilemap
+ * @param x The tile's column
+ * @param y The tile's row
+ * @return The tile id (0 for empty or out of range)
+ */
+unsigned short getTile(Tilemap* map, int x, int y) {
+  // Verify the map and coordinates
+  if (!map || x < 0 || y < 0 || x >= map -> width || y >= map -> height)
+    return 0;
+
+  return map -> tiles[(size_t) y * (map -> width) + x];
+}
+
+/**
+ * @brief Moves a tilemap (render call)
+ * 
+ * @param data The arguments of moveTilemap()
+ */
+static void moveTilemapCall(void* data) {
+  void** args = (void**) data;
+  moveTilemap((Tilemap*) args[0], (float*) args[1]);
+}
+
+/**
+ * @brief Moves a tilemap
+ * 
+ * @param map The tilemap
+ * @param delta The change in position
+ */
+void moveTilemap(Tilemap* map, float delta[3]) {
+  // Verify the map and delta
+  if (!map || !delta)
+    return;
+
+  // Tilemaps belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    void* args[2] = { map, delta };
+    renderCall(moveTilemapCall, args);
+    return;
+  }
+
+  map -> position[0] += delta[0];
+  map -> position[1] += delta[1];
+  map -> position[2] += delta[2];
+  requestFrame();
+}
+
+/**
+ * @brief Destroys a tilemap (render call)
+ * 
+ * @param data The tilemap
+ */
+static void destroyTilemapCall(void* data) {
+  destroyTilemap((Tilemap*) data);
+}
+
+/**
+ * @brief Destroys a tilemap, releasing its chunks once the GPU is done with them
+ * 
+ * @param map The tilemap
+ */
+void destroyTilemap(Tilemap* map) {
+  // Verify the map
+  if (!map)
+    return;
+
+  // Tilemaps belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    renderCall(destroyTilemapCall, map);
+    return;
+  }
+
+  // Rotate the tilemap queue once, dropping the map
+  register unsigned int itr, count = queueSize(tilemaps);
+  for (itr = 0; itr < count; itr++) {
+    Tilemap* other = dequeue(tilemaps);
+    if (other != map)
+      enqueue(tilemaps, other);
+  }
+
+  // Release the GL objects
+  collectGarbage(map -> program, 0, 0, 0);
+  for (itr = 0; itr < (unsigned int) (map -> columns) * (map -> rows); itr++)
+    if (map -> chunks[itr].vao)
+      collectGarbage(0, map -> chunks[itr].vao, map -> chunks[itr].vbo, 0);
+
+  trackMemory(MEMORY_TILEMAPS, -(long long) (sizeof(Tilemap) + sizeof(unsigned short) * (map -> width) * (map -> height) + sizeof(Chunk) * (map -> columns) * (map -> rows)));
+  memFree(map -> chunks);
+  memFree(map -> tiles);
+  memFree(map);
+  requestFrame();
+}
+
+/**
+ * @brief Bakes the non-empty tiles of a chunk into its vertex buffer
+ * 
+ * @param map The tilemap
+ * @param column The chunk's column
+ * @param row The chunk's row
+ */
+static void bakeChunk(Tilemap* map, int column, int row) {
+  Chunk* chunk = &(map -> chunks[row * (map -> columns) + column]);
+
+  // Create the chunk's buffers the first time it's baked
+  if (chunk -> vao == 0) {
+    glGenVertexArrays(1, &(chunk -> vao));
+    glGenBuffers(1, &(chunk -> vbo));
+    glBindVertexArray(chunk -> vao);
+    glBindBuffer(GL_ARRAY_BUFFER, chunk -> vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*) (3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+  }
+
+  // Emit two triangles (x, y, z, tile per vertex) for every non-empty tile (a write while baking dirties it again)
+  if (!bakery)
+    bakery = (float*) memAlignedAlloc(sizeof(float) * 4 * 6 * TILEMAP_CHUNK * TILEMAP_CHUNK, 64);
+  float* vertex = bakery;
+  register int x, y;
+  SDL_AtomicLock(&(map -> lock));
+  chunk -> dirty = false;
+  for (y = row * TILEMAP_CHUNK; y < (row + 1) * TILEMAP_CHUNK && y < map -> height; y++) {
+    for (x = column * TILEMAP_CHUNK; x < (column + 1) * TILEMAP_CHUNK && x < map -> width; x++) {
+      unsigned short tile = map -> tiles[(size_t) y * (map -> width) + x];
+      if (!tile)
+        continue;
+
+      float left = x * (map -> tileWidth), right = left + map -> tileWidth;
+      float bottom = y * (map -> tileHeight), top = bottom + map -> tileHeight;
+      float corners[6][2] = { { right, top }, { right, bottom }, { left, top }, { right, bottom }, { left, bottom }, { left, top } };
+      register int corner;
+      for (corner = 0; corner < 6; corner++) {
+        *vertex++ = corners[corner][0];
+        *vertex++ = corners[corner][1];
+        *vertex++ = 0.0f;
+        *vertex++ = (float) tile;
+      }
+    }
+  }
+  SDL_AtomicUnlock(&(map -> lock));
+
+  // Upload the chunk as a static buffer
+  unsigned int count = (unsigned int) ((vertex - bakery) / 4);
+  trackMemory(MEMORY_GL_BUFFERS, (long long) sizeof(float) * 4 * ((long long) count - chunk -> count));
+  chunk -> count = count;
+  glBindBuffer(GL_ARRAY_BUFFER, chunk -> vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 4 * (chunk -> count), bakery, GL_STATIC_DRAW);
+}
+
+/**
+ * @brief Draws the chunks of every tilemap that intersect the screen, baking dirty ones
+ * 
+ * @return The number of draw calls
+ */
+static unsigned int drawTilemaps(void) {
+  unsigned int draws = 0;
+  QueueIterator itr = iterateQueue(tilemaps);
+  Tilemap* map;
+  while ((map = nextElement(&itr))) {
+    // Find the range of chunks on screen
+    float chunkWidth = TILEMAP_CHUNK * (map -> tileWidth), chunkHeight = TILEMAP_CHUNK * (map -> tileHeight);
+    int left = (int) floorf((-1.0f - map -> position[0]) / chunkWidth);
+    int right = (int) floorf((1.0f - map -> position[0]) / chunkWidth);
+    int bottom = (int) floorf((-1.0f - map -> position[1]) / chunkHeight);
+    int top = (int) floorf((1.0f - map -> position[1]) / chunkHeight);
+    if (left < 0)
+      left = 0;
+    if (bottom < 0)
+      bottom = 0;
+    if (right >= map -> columns)
+      right = map -> columns - 1;
+    if (top >= map -> rows)
+      top = map -> rows - 1;
+    if (left > right || bottom > top)
+      continue;
+
+    // Draw them, baking any that changed (the flag is peeked without the lock; a late write requests another frame)
+    glUseProgram(map -> program);
+    glUniform3fv(map -> location, 1, map -> position);
+    register int row, column;
+    for (row = bottom; row <= top; row++) {
+      for (column = left; column <= right; column++) {
+        Chunk* chunk = &(map -> chunks[row * (map -> columns) + column]);
+        if (chunk -> dirty || chunk -> vao == 0)
+          bakeChunk(map, column, row);
+        if (chunk -> count == 0)
+          continue;
+
+        glBindVertexArray(chunk -> vao);
+        glDrawArrays(GL_TRIANGLES, 0, chunk -> count);
+        draws++;
+      }
+    }
+  }
+
+  return draws;
+}
+
+/**
+ * @brief Creates a particle emitter (render call)
+ * 
+ * @param data The arguments of createEmitter() and a pointer to its result
+ */
+static void createEmitterCall(void* data) {
+  void** args = (void**) data;
+  *(Emitter**) args[5] = createEmitter(*(unsigned int*) args[0], (float*) args[1], (const EmitterSettings*) args[2], (const char*) args[3], (const char*) args[4]);
+}
+
+/**
+ * @brief Creates a particle emitter
+ * 
+ * @param capacity The most particles alive at once
+ * @param position Where particles spawn
+ * @param settings How particles spawn and move
+ * @param vertFile Vertex shader filename
+ * @param fragFile Fragment shader filename
+ * @return A pointer to the emitter
+ */
+Emitter* createEmitter(unsigned int capacity, float position[3], const EmitterSettings* settings, const char* vertFile, const char* fragFile) {
+  // Verify the capacity, position, settings and filenames
+  if (capacity == 0 || !position || !settings || !vertFile || !fragFile)
+    return NULL;
+
+  // Emitters belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    Emitter* emitter = NULL;
+    void* args[6] = { &capacity, position, (void*) settings, (void*) vertFile, (void*) fragFile, &emitter };
+    renderCall(createEmitterCall, args);
+    return emitter;
+  }
+
+  // Create the emitter
+  Emitter* emitter = (Emitter*) memCalloc(1, sizeof(Emitter));
+  if (!emitter)
+    error("Failed to allocate emitter!");
+  emitter -> vertFile = vertFile;
+  emitter -> fragFile = fragFile;
+  memcpy(emitter -> position, position, sizeof(emitter -> position));
+  emitter -> settings = *settings;
+  emitter -> seed = 0x9E3779B9u ^ (uint32_t) (uintptr_t) emitter;
+
+  // Allocate the particle arrays (padded to whole cache lines, so every array stays aligned)
+  emitter -> capacity = (capacity + 15) & ~15u;
+  emitter -> block = (float*) memAlignedAlloc(sizeof(float) * 6 * (emitter -> capacity), 64);
+  if (!(emitter -> block))
+    error("Failed to allocate particles!");
+  memset(emitter -> block, 0, sizeof(float) * 6 * (emitter -> capacity));
+  emitter -> x = emitter -> block;
+  emitter -> y = emitter -> x + emitter -> capacity;
+  emitter -> vx = emitter -> y + emitter -> capacity;
+  emitter -> vy = emitter -> vx + emitter -> capacity;
+  emitter -> age = emitter -> vy + emitter -> capacity;
+  emitter -> life = emitter -> age + emitter -> capacity;
+  trackMemory(MEMORY_PARTICLES, sizeof(Emitter) + sizeof(float) * 6 * (emitter -> capacity));
+
+  // Create the particle state buffers on the GPU, or the streaming buffer (a vec4 per particle)
+  if (settings -> gpu)
+    createParticleStates(emitter);
+  else {
+    glGenVertexArrays(1, &(emitter -> vao));
+    glGenBuffers(1, &(emitter -> vbo));
+    glBindVertexArray(emitter -> vao);
+    glBindBuffer(GL_ARRAY_BUFFER, emitter -> vbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 4 * (emitter -> capacity), NULL, GL_STREAM_DRAW);
+    trackMemory(MEMORY_GL_BUFFERS, sizeof(float) * 4 * (emitter -> capacity));
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*) 0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, 4 * sizeof(float), (void*) (3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+  }
+
+  // Load the shader program (particles are in clip space, so the position uniform stays at the origin)
+  emitter -> program = loadProgram(vertFile, fragFile, false);
+  emitter -> location = glGetUniformLocation(emitter -> program, "position");
+
+  enqueue(emitters, emitter);
+  requestFrame();
+  return emitter;
+}
+
+/**
+ * @brief Changes an emitter's settings (render call)
+ * 
+ * @param data The arguments of configureEmitter()
+ */
+static void configureEmitterCall(void* data) {
+  void** args = (void**) data;
+  configureEmitter((Emitter*) args[0], (const EmitterSettings*) args[1]);
+}
+
+/**
+ * @brief Changes how an emitter spawns and moves its particles
+ * 
+ * @param emitter The emitter
+ * @param settings The new settings
+ */
+void configureEmitter(Emitter* emitter, const EmitterSettings* settings) {
+  // Verify the emitter and settings
+  if (!emitter || !settings)
+    return;
+
+  // Emitters belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    void* args[2] = { emitter, (void*) settings };
+    renderCall(configureEmitterCall, args);
+    return;
+  }
+
+  // The mode is fixed at creation
+  bool gpu = emitter -> settings.gpu;
+  emitter -> settings = *settings;
+  emitter -> settings.gpu = gpu;
+  requestFrame();
+}
+
+/**
+ * @brief Moves an emitter (render call)
+ * 
+ * @param data The arguments of moveEmitter()
+ */
+static void moveEmitterCall(void* data) {
+  void** args = (void**) data;
+  moveEmitter((Emitter*) args[0], (float*) args[1]);
+}
+
+/**
+ * @brief Moves where an emitter spawns particles (live particles stay put)
+ * 
+ * @param emitter The emitter
+ * @param delta The change in position
+ */
+void moveEmitter(Emitter* emitter, float delta[3]) {
+  // Verify the emitter and delta
+  if (!emitter || !delta)
+    return;
+
+  // Emitters belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    void* args[2] = { emitter, delta };
+    renderCall(moveEmitterCall, args);
+    return;
+  }
+
+  emitter -> position[0] += delta[0];
+  emitter -> position[1] += delta[1];
+  emitter -> position[2] += delta[2];
+  requestFrame();
+}
+
+/**
+ * @brief Queues a burst of particles (render call)
+ * 
+ * @param data The arguments of burstEmitter()
+ */
+static void burstEmitterCall(void* data) {
+  void** args = (void**) data;
+  burstEmitter((Emitter*) args[0], *(unsigned int*) args[1]);
+}
+
+/**
+ * @brief Spawns particles at once on the next update
+ * 
+ * @param emitter The emitter
+ * @param count The number of particles
+ */
+void burstEmitter(Emitter* emitter, unsigned int count) {
+  // Verify the emitter
+  if (!emitter)
+    return;
+
+  // Emitters belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    void* args[2] = { emitter, &count };
+    renderCall(burstEmitterCall, args);
+    return;
+  }
+
+  emitter -> burst += count;
+  requestFrame();
+}
+
+/**
+ * @brief Destroys an emitter (render call)
+ * 
+ * @param data The emitter
+ */
+static void destroyEmitterCall(void* data) {
+  destroyEmitter((Emitter*) data);
+}
+
+/**
+ * @brief Destroys an emitter and its particles
+ * 
+ * @param emitter The emitter
+ */
+void destroyEmitter(Emitter* emitter) {
+  // Verify the emitter
+  if (!emitter)
+    return;
+
+  // Emitters belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    renderCall(destroyEmitterCall, emitter);
+    return;
+  }
+
+  // Rotate the emitter queue once, dropping the emitter
+  register unsigned int itr, count = queueSize(emitters);
+  for (itr = 0; itr < count; itr++) {
+    Emitter* other = dequeue(emitters);
+    if (other != emitter)
+      enqueue(emitters, other);
+  }
+
+  // Release the GL objects once the GPU is done with them, and the particles right away
+  collectGarbage(emitter -> program, emitter -> vao, emitter -> vbo, 0);
+  if (emitter -> settings.gpu) {
+    collectGarbage(0, emitter -> updateArrays[0], emitter -> states[0], 0);
+    collectGarbage(0, emitter -> updateArrays[1], emitter -> states[1], 0);
+    collectGarbage(0, emitter -> drawArrays[0], 0, 0);
+    collectGarbage(0, emitter -> drawArrays[1], 0, 0);
+  }
+  trackMemory(MEMORY_PARTICLES, -(long long) (sizeof(Emitter) + sizeof(float) * 6 * (emitter -> capacity)));
+  memAlignedFree(emitter -> block, 64);
+  memFree(emitter);
+  requestFrame();
+}
+
+/**
+ * @brief Draws a uniform random number
+ * 
+ * @param seed The generator state (xorshift32)
+ * @return A number in [-1, 1)
+ */
+static inline float randomParticle(uint32_t* seed) {
+  uint32_t value = *seed;
+  value ^= value << 13;
+  value ^= value >> 17;
+  value ^= value << 5;
+  *seed = value;
+  return (value >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+/**
+ * @brief Counts the particles an emitter should spawn this step
+ * 
+ * @param emitter The emitter
+ * @param delta The time step (seconds)
+ * @return The number of particles (the emission rate's whole particles plus any burst)
+ */
+static unsigned int dueParticles(Emitter* emitter, float delta) {
+  emitter -> pending += emitter -> settings.rate * delta;
+  unsigned int spawn = (unsigned int) (emitter -> pending) + emitter -> burst;
+  emitter -> pending -= (unsigned int) (emitter -> pending);
+  emitter -> burst = 0;
+  return spawn;
+}
+
+/**
+ * @brief Creates the ping-pong state buffers of a GPU emitter (and the shared update program)
+ * 
+ * @param emitter The emitter
+ */
+static void createParticleStates(Emitter* emitter) {
+  // Build the update program the first time it's needed
+  if (!particleProgram) {
+    static const char* source =
+      "#version 330 core\n"
+      "layout (location = 0) in vec2 position;\n"
+      "layout (location = 1) in vec2 velocity;\n"
+      "layout (location = 2) in float age;\n"
+      "layout (location = 3) in float inverseLife;\n"
+      "uniform float delta;\n"
+      "uniform vec2 gravity;\n"
+      "out vec2 outPosition;\n"
+      "out vec2 outVelocity;\n"
+      "out float outAge;\n"
+      "out float outInverseLife;\n"
+      "void main() {\n"
+      "  outAge = min(age + delta * inverseLife, 1.0);\n"
+      "  outInverseLife = inverseLife;\n"
+      "  bool alive = outAge < 1.0;\n"
+      "  outVelocity = alive ? velocity + gravity * delta : vec2(0.0);\n"
+      "  outPosition = alive ? position + outVelocity * delta : vec2(1.0e9);\n"
+      "}\n";
+    static const char* varyings[4] = { "outPosition", "outVelocity", "outAge", "outInverseLife" };
+
+    GLuint stage = compileStage(GL_VERTEX_SHADER, source);
+    particleProgram = glCreateProgram();
+    glAttachShader(particleProgram, stage);
+    glTransformFeedbackVaryings(particleProgram, 4, varyings, GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(particleProgram);
+    glDetachShader(particleProgram, stage);
+    glDeleteShader(stage);
+    GLint status;
+    glGetProgramiv(particleProgram, GL_LINK_STATUS, &status);
+    if (!stage || status != GL_TRUE)
+      error("Failed to create particle update program!");
+    particleDelta = glGetUniformLocation(particleProgram, "delta");
+    particleGravity = glGetUniformLocation(particleProgram, "gravity");
+  }
+
+  // Start every slot dead (parked outside clip space)
+  float* records = emitter -> block;
+  register unsigned int itr;
+  for (itr = 0; itr < emitter -> capacity; itr++) {
+    float* record = records + itr * GPU_PARTICLE_FLOATS;
+    record[0] = record[1] = 1.0e9f;
+    record[2] = record[3] = 0.0f;
+    record[4] = record[5] = 1.0f;
+  }
+
+  // Create both buffers with a vertex array for updating and one for drawing
+  GLsizei stride = GPU_PARTICLE_FLOATS * sizeof(float);
+  glGenBuffers(2, emitter -> states);
+  glGenVertexArrays(2, emitter -> updateArrays);
+  glGenVertexArrays(2, emitter -> drawArrays);
+  for (itr = 0; itr < 2; itr++) {
+    glBindBuffer(GL_ARRAY_BUFFER, emitter -> states[itr]);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr) stride * (emitter -> capacity), records, GL_DYNAMIC_COPY);
+
+    glBindVertexArray(emitter -> updateArrays[itr]);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*) 0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride, (void*) (2 * sizeof(float)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*) (4 * sizeof(float)));
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride, (void*) (5 * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glEnableVertexAttribArray(3);
+
+    glBindVertexArray(emitter -> drawArrays[itr]);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride, (void*) 0);
+    glVertexAttribPointer(1, 1, GL_FLOAT, GL_FALSE, stride, (void*) (4 * sizeof(float)));
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+  }
+  glBindVertexArray(0);
+  trackMemory(MEMORY_GL_BUFFERS, 2LL * stride * (emitter -> capacity));
+}
+
+/**
+ * @brief Spawns into and advances a GPU emitter's particles, without reading anything back
+ * 
+ * @param emitter The emitter
+ * @param delta The time step (seconds)
+ */
+static void updateParticleStates(Emitter* emitter, float delta) {
+  GLsizei stride = GPU_PARTICLE_FLOATS * sizeof(float);
+
+  // Write the new particles over the oldest ring slots (the only upload)
+  unsigned int spawn = dueParticles(emitter, delta);
+  if (spawn > emitter -> capacity)
+    spawn = emitter -> capacity;
+  emitter -> remaining = spawn ? emitter -> settings.life : emitter -> remaining - delta;
+  if (spawn) {
+    const EmitterSettings* settings = &(emitter -> settings);
+    float* records = emitter -> block;
+    register unsigned int itr;
+    for (itr = 0; itr < spawn; itr++) {
+      float* record = records + itr * GPU_PARTICLE_FLOATS;
+      record[0] = emitter -> position[0];
+      record[1] = emitter -> position[1];
+      record[2] = settings -> velocity[0] + settings -> spread * randomParticle(&(emitter -> seed));
+      record[3] = settings -> velocity[1] + settings -> spread * randomParticle(&(emitter -> seed));
+      record[4] = 0.0f;
+      record[5] = 1.0f / (settings -> life * (0.875f + 0.125f * randomParticle(&(emitter -> seed))));
+    }
+
+    unsigned int first = emitter -> capacity - emitter -> head;
+    if (first > spawn)
+      first = spawn;
+    glBindBuffer(GL_ARRAY_BUFFER, emitter -> states[emitter -> current]);
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr) stride * (emitter -> head), (GLsizeiptr) stride * first, records);
+    if (spawn > first)
+      glBufferSubData(GL_ARRAY_BUFFER, 0, (GLsizeiptr) stride * (spawn - first), records + first * GPU_PARTICLE_FLOATS);
+    emitter -> head = (emitter -> head + spawn) % (emitter -> capacity);
+    if (emitter -> count < emitter -> capacity)
+      emitter -> count = emitter -> count + spawn < emitter -> capacity ? emitter -> count + spawn : emitter -> capacity;
+    stats.uploadBytes += (unsigned long long) spawn * stride;
+  }
+  if (emitter -> count == 0)
+    return;
+
+  // Advance every used slot from one buffer into the other
+  glUseProgram(particleProgram);
+  glUniform1f(particleDelta, delta);
+  glUniform2fv(particleGravity, 1, emitter -> settings.gravity);
+  glEnable(GL_RASTERIZER_DISCARD);
+  glBindVertexArray(emitter -> updateArrays[emitter -> current]);
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, emitter -> states[emitter -> current ^ 1]);
+  glBeginTransformFeedback(GL_POINTS);
+  glDrawArrays(GL_POINTS, 0, emitter -> count);
+  glEndTransformFeedback();
+  glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+  glDisable(GL_RASTERIZER_DISCARD);
+  emitter -> current ^= 1;
+}
+
+/**
+ * @brief Ages, integrates and compacts an emitter's particles, then spawns new ones
+ * 
+ * @param emitter The emitter
+ * @param delta The time step (seconds)
+ */
+static void updateParticles(Emitter* emitter, float delta) {
+  float* restrict x = emitter -> x;
+  float* restrict y = emitter -> y;
+  float* restrict vx = emitter -> vx;
+  float* restrict vy = emitter -> vy;
+  float* restrict age = emitter -> age;
+  float* restrict life = emitter -> life;
+  unsigned int count = emitter -> count;
+  float ax = emitter -> settings.gravity[0] * delta, ay = emitter -> settings.gravity[1] * delta;
+
+  // Integrate and age four particles at a time (the arrays are padded, so the tail lanes are harmless)
+  register unsigned int itr = 0;
+  #if defined(__SSE__) || defined(_M_X64)
+    __m128 step = _mm_set1_ps(delta), stepX = _mm_set1_ps(ax), stepY = _mm_set1_ps(ay);
+    for (; itr < count; itr += 4) {
+      __m128 velocityX = _mm_add_ps(_mm_load_ps(vx + itr), stepX);
+      __m128 velocityY = _mm_add_ps(_mm_load_ps(vy + itr), stepY);
+      _mm_store_ps(vx + itr, velocityX);
+      _mm_store_ps(vy + itr, velocityY);
+      _mm_store_ps(x + itr, _mm_add_ps(_mm_load_ps(x + itr), _mm_mul_ps(velocityX, step)));
+      _mm_store_ps(y + itr, _mm_add_ps(_mm_load_ps(y + itr), _mm_mul_ps(velocityY, step)));
+      _mm_store_ps(age + itr, _mm_add_ps(_mm_load_ps(age + itr), step));
+    }
+  #else
+    for (; itr < count; itr++) {
+      vx[itr] += ax;
+      vy[itr] += ay;
+      x[itr] += vx[itr] * delta;
+      y[itr] += vy[itr] * delta;
+      age[itr] += delta;
+    }
+  #endif
+
+  // Swap every dead particle with the last live one (skipping all-alive groups of four)
+  itr = 0;
+  while (itr < count) {
+    #if defined(__SSE__) || defined(_M_X64)
+      if ((itr & 3) == 0 && itr + 4 <= count && _mm_movemask_ps(_mm_cmpge_ps(_mm_load_ps(age + itr), _mm_load_ps(life + itr))) == 0) {
+        itr += 4;
+        continue;
+      }
+    #endif
+    if (age[itr] < life[itr]) {
+      itr++;
+      continue;
+    }
+    count--;
+    x[itr] = x[count];
+    y[itr] = y[count];
+    vx[itr] = vx[count];
+    vy[itr] = vy[count];
+    age[itr] = age[count];
+    life[itr] = life[count];
+  }
+
+  // Spawn the particles due this step
+  unsigned int spawn = dueParticles(emitter, delta);
+  if (spawn > emitter -> capacity - count)
+    spawn = emitter -> capacity - count;
+  const EmitterSettings* settings = &(emitter -> settings);
+  for (itr = count; itr < count + spawn; itr++) {
+    x[itr] = emitter -> position[0];
+    y[itr] = emitter -> position[1];
+    vx[itr] = settings -> velocity[0] + settings -> spread * randomParticle(&(emitter -> seed));
+    vy[itr] = settings -> velocity[1] + settings -> spread * randomParticle(&(emitter -> seed));
+    age[itr] = 0.0f;
+    life[itr] = settings -> life * (0.875f + 0.125f * randomParticle(&(emitter -> seed)));
+  }
+  emitter -> count = count + spawn;
+}
+
+/**
+ * @brief Interleaves an emitter's live particles into its streaming buffer
+ * 
+ * @param emitter The emitter
+ * @param vertices The mapped buffer (x, y, z, age / life per particle)
+ */
+static void streamParticles(Emitter* emitter, float* vertices) {
+  const float* x = emitter -> x;
+  const float* y = emitter -> y;
+  const float* age = emitter -> age;
+  const float* life = emitter -> life;
+  float z = emitter -> position[2];
+  unsigned int count = emitter -> count;
+
+  // Transpose four particles at a time into four vertices
+  register unsigned int itr = 0;
+  #if defined(__SSE__) || defined(_M_X64)
+    __m128 depth = _mm_set1_ps(z);
+    for (; itr + 4 <= count; itr += 4) {
+      __m128 column0 = _mm_load_ps(x + itr);
+      __m128 column1 = _mm_load_ps(y + itr);
+      __m128 column2 = depth;
+      __m128 column3 = _mm_div_ps(_mm_load_ps(age + itr), _mm_load_ps(life + itr));
+      _MM_TRANSPOSE4_PS(column0, column1, column2, column3);
+      _mm_storeu_ps(vertices + itr * 4, column0);
+      _mm_storeu_ps(vertices + itr * 4 + 4, column1);
+      _mm_storeu_ps(vertices + itr * 4 + 8, column2);
+      _mm_storeu_ps(vertices + itr * 4 + 12, column3);
+    }
+  #endif
+  for (; itr < count; itr++) {
+    vertices[itr * 4] = x[itr];
+    vertices[itr * 4 + 1] = y[itr];
+    vertices[itr * 4 + 2] = z;
+    vertices[itr * 4 + 3] = age[itr] / life[itr];
+  }
+}
+
+/**
+ * @brief Advances every emitter and draws each with a single call
+ * 
+ * @return The number of draw calls
+ */
+static unsigned int drawEmitters(void) {
+  // Step the particles by the time since the last frame (capped, so a stall doesn't explode them)
+  Uint64 now = SDL_GetPerformanceCounter();
+  float delta = particleClock ? (float) (now - particleClock) / SDL_GetPerformanceFrequency() : 0.0f;
+  particleClock = now;
+  if (delta > 0.1f)
+    delta = 0.1f;
+
+  unsigned int draws = 0;
+  QueueIterator itr = iterateQueue(emitters);
+  Emitter* emitter;
+  while ((emitter = nextElement(&itr))) {
+    // Keep frames coming while the emitter spawns or has particles alive
+    if (emitter -> settings.rate > 0.0f || emitter -> burst || (emitter -> settings.gpu ? emitter -> remaining > 0.0f : emitter -> count > 0))
+      requestFrame();
+
+    // Advance GPU particles in place and draw every used slot (dead ones are clipped)
+    if (emitter -> settings.gpu) {
+      updateParticleStates(emitter, delta);
+      if (emitter -> count == 0)
+        continue;
+
+      glUseProgram(emitter -> program);
+      glUniform3f(emitter -> location, 0.0f, 0.0f, emitter -> position[2]);
+      glPointSize(emitter -> settings.size > 0.0f ? emitter -> settings.size : 1.0f);
+      glBindVertexArray(emitter -> drawArrays[emitter -> current]);
+      glDrawArrays(GL_POINTS, 0, emitter -> count);
+      draws++;
+      stats.particles += emitter -> count;
+      continue;
+    }
+
+    updateParticles(emitter, delta);
+    if (emitter -> count == 0)
+      continue;
+
+    // Stream the particles into freshly orphaned storage
+    glBindBuffer(GL_ARRAY_BUFFER, emitter -> vbo);
+    float* vertices = (float*) glMapBufferRange(GL_ARRAY_BUFFER, 0, sizeof(float) * 4 * (emitter -> capacity), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (!vertices)
+      continue;
+    streamParticles(emitter, vertices);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+
+    // Draw them as points in one call
+    glUseProgram(emitter -> program);
+    glUniform3f(emitter -> location, 0.0f, 0.0f, 0.0f);
+    glPointSize(emitter -> settings.size > 0.0f ? emitter -> settings.size : 1.0f);
+    glBindVertexArray(emitter -> vao);
+    glDrawArrays(GL_POINTS, 0, emitter -> count);
+    draws++;
+    stats.particles += emitter -> count;
+    stats.uploadBytes += (unsigned long long) (emitter -> count) * sizeof(float) * 4;
+  }
+
+  return draws;
+}
+
+/**
+ * @brief The built-in font (5x7 glyphs from space to DEL, a byte per row from the top, bit 4 leftmost)
+ */
+static const unsigned char fontGlyphs[FONT_GLYPHS][7] = {
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // space
+  { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },   // !
+  { 0x0A, 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00 },   // "
+  { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A },   // #
+  { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04 },   // $
+  { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },   // %
+  { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D },   // &
+  { 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 },   // quote
+  { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },   // (
+  { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },   // )
+  { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00 },   // *
+  { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },   // +
+  { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 },   // ,
+  { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },   // -
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },   // .
+  { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },   // /
+  { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },   // 0
+  { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },   // 1
+  { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },   // 2
+  { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },   // 3
+  { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },   // 4
+  { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },   // 5
+  { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },   // 6
+  { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   // 7
+  { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },   // 8
+  { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },   // 9
+  { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },   // :
+  { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x04, 0x08 },   // ;
+  { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },   // <
+  { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 },   // =
+  { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },   // >
+  { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },   // ?
+  { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E },   // @
+  { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // A
+  { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },   // B
+  { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },   // C
+  { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },   // D
+  { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },   // E
+  { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },   // F
+  { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },   // G
+  { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // H
+  { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   // I
+  { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },   // J
+  { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },   // K
+  { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },   // L
+  { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },   // M
+  { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },   // N
+  { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // O
+  { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },   // P
+  { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },   // Q
+  { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },   // R
+  { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },   // S
+  { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // T
+  { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // U
+  { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },   // V
+  { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },   // W
+  { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },   // X
+  { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 },   // Y
+  { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },   // Z
+  { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E },   // [
+  { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },   // backslash
+  { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E },   // ]
+  { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00 },   // ^
+  { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },   // _
+  { 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 },   // `
+  { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F },   // a
+  { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E },   // b
+  { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E },   // c
+  { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F },   // d
+  { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E },   // e
+  { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08 },   // f
+  { 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E },   // g
+  { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },   // h
+  { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E },   // i
+  { 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C },   // j
+  { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },   // k
+  { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   // l
+  { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11 },   // m
+  { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },   // n
+  { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E },   // o
+  { 0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10 },   // p
+  { 0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01 },   // q
+  { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },   // r
+  { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E },   // s
+  { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06 },   // t
+  { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D },   // u
+  { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04 },   // v
+  { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A },   // w
+  { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11 },   // x
+  { 0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E },   // y
+  { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F },   // z
+  { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 },   // {
+  { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // |
+  { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 },   // }
+  { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 },   // ~
+  { 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F, 0x1F }    // DEL
+};
+
+/**
+ * @brief Creates a font (render call)
+ * 
+ * @param data The arguments of createFont() and a pointer to its result
+ */
+static void createFontCall(void* data) {
+  void** args = (void**) data;
+  *(Font**) args[3] = createFont((const char*) args[0], *(int*) args[1], *(int*) args[2]);
+}
+
+/**
+ * @brief Creates a font from a BMP font sheet, or the built-in 5x7 font
+ * 
+ * @param filename The font sheet (FONT_GLYPHS glyphs from space, FONT_COLUMNS to a row from the top-left), NULL for the built-in font
+ * @param cellWidth The width of a glyph in the sheet (pixels)
+ * @param cellHeight The height of a glyph in the sheet (pixels)
+ * @return A pointer to the font, NULL if the sheet couldn't be loaded
+ */
+Font* createFont(const char* filename, int cellWidth, int cellHeight) {
+  // Verify the glyph size of a font sheet
+  if (filename && (cellWidth <= 0 || cellHeight <= 0))
+    return NULL;
+
+  // Fonts belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    Font* font = NULL;
+    void* args[4] = { (void*) filename, &cellWidth, &cellHeight, &font };
+    renderCall(createFontCall, args);
+    return font;
+  }
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  // Rasterize the glyph coverage, bottom row first like decoded BMPs
+  unsigned char* coverage;
+  int width, height;
+  register int itr;
+  if (filename) {
+    BMP* sheet = loadBMP(filename);
+    unsigned char* pixels = sheet ? decodeBMP(sheet) : NULL;
+    if (!pixels) {
+      if (sheet)
+        freeBMP(sheet);
+      fprintf(stderr, "Error: Could not load font sheet.\n");
+      return NULL;
+    }
+    width = (int32_t) sheet -> header.width;
+    height = abs((int32_t) sheet -> header.height);
+    if (width < cellWidth * FONT_COLUMNS || height < cellHeight * (FONT_GLYPHS / FONT_COLUMNS)) {
+      memFree(pixels);
+      freeBMP(sheet);
+      fprintf(stderr, "Error: Font sheet is too small for its glyphs.\n");
+      return NULL;
+    }
+
+    // Use the alpha channel if it varies, the brightest channel otherwise
+    unsigned char low = 255, high = 0;
+    for (itr = 0; itr < width * height && sheet -> header.bitsperpixel == 32; itr++) {
+      low = pixels[itr * 4 + 3] < low ? pixels[itr * 4 + 3] : low;
+      high = pixels[itr * 4 + 3] > high ? pixels[itr * 4 + 3] : high;
+    }
+    coverage = (unsigned char*) memAlloc((size_t) width * height);
+    if (!coverage)
+      error("Failed to allocate font atlas!");
+    for (itr = 0; itr < width * height; itr++) {
+      const unsigned char* pixel = pixels + itr * 4;
+      unsigned char bright = pixel[0] > pixel[1] ? pixel[0] : pixel[1];
+      bright = pixel[2] > bright ? pixel[2] : bright;
+      coverage[itr] = low < high ? pixel[3] : bright;
+    }
+    memFree(pixels);
+    freeBMP(sheet);
+  } else {
+    cellWidth = 6;
+    cellHeight = 8;
+    width = cellWidth * FONT_COLUMNS;
+    height = cellHeight * (FONT_GLYPHS / FONT_COLUMNS);
+    coverage = (unsigned char*) memCalloc((size_t) width * height, 1);
+    if (!coverage)
+      error("Failed to allocate font atlas!");
+    int row, column;
+    for (itr = 0; itr < FONT_GLYPHS; itr++)
+      for (row = 0; row < 7; row++)
+        for (column = 0; column < 5; column++)
+          if (fontGlyphs[itr][row] & (0x10 >> column))
+            coverage[(height - 1 - (itr / FONT_COLUMNS) * cellHeight - row) * width + (itr % FONT_COLUMNS) * cellWidth + column] = 255;
+  }
+
+  // Create the text program and batch buffer the first time they're needed
+  if (!textProgram) {
+    static const char* vertSource =
+      "#version 330 core\n"
+      "layout (location = 0) in vec3 position;\n"
+      "layout (location = 1) in vec2 coordinates;\n"
+      "layout (location = 2) in vec4 color;\n"
+      "out vec2 glyph;\n"
+      "out vec4 tint;\n"
+      "void main() {\n"
+      "  gl_Position = vec4(position, 1.0);\n"
+      "  glyph = coordinates;\n"
+      "  tint = color;\n"
+      "}\n";
+    static const char* fragSource =
+      "#version 330 core\n"
+      "in vec2 glyph;\n"
+      "in vec4 tint;\n"
+      "uniform sampler2D atlas;\n"
+      "out vec4 color;\n"
+      "void main() {\n"
+      "  color = vec4(tint.rgb, tint.a * texture(atlas, glyph).r);\n"
+      "}\n";
+    textProgram = compileProgram(vertSource, fragSource);
+    if (!textProgram)
+      error("Failed to create text program!");
+
+    glGenVertexArrays(1, &textArray);
+    glGenBuffers(1, &textBuffer);
+    glBindVertexArray(textArray);
+    glBindBuffer(GL_ARRAY_BUFFER, textBuffer);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (void*) offsetof(GlyphVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (void*) offsetof(GlyphVertex, coordinates));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphVertex), (void*) offsetof(GlyphVertex, color));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+  }
+
+  // Upload the atlas
+  Font* font = (Font*) memCalloc(1, sizeof(Font));
+  if (!font)
+    error("Failed to allocate font!");
+  font -> width = width;
+  font -> height = height;
+  font -> cellWidth = cellWidth;
+  font -> cellHeight = cellHeight;
+  glGenTextures(1, &(font -> texture));
+  glBindTexture(GL_TEXTURE_2D, font -> texture);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, width, height, 0, GL_RED, GL_UNSIGNED_BYTE, coverage);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  memFree(coverage);
+  trackMemory(MEMORY_GL_TEXTURES, (long long) width * height);
+  trackMemory(MEMORY_TEXT, sizeof(Font));
+
+  enqueue(fonts, font);
+  recordLoadMetrics(LOAD_FONT, start);
+  return font;
+}
+
+/**
+ * @brief Frees a text (already removed from the text queue)
+ * 
+ * @param text The text
+ */
+static void freeText(Text* text) {
+  trackMemory(MEMORY_TEXT, -(long long) (sizeof(Text) + strlen(text -> string) + 1 + sizeof(GlyphVertex) * (text -> capacity)));
+  memFree(text -> vertices);
+  memFree(text -> string);
+  memFree(text);
+}
+
+/**
+ * @brief Destroys a font (render call)
+ * 
+ * @param data The font
+ */
+static void destroyFontCall(void* data) {
+  destroyFont((Font*) data);
+}
+
+/**
+ * @brief Destroys a font and every text using it
+ * 
+ * @param font The font
+ */
+void destroyFont(Font* font) {
+  // Verify that the font exists
+  if (!font)
+    return;
+
+  // Fonts belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    renderCall(destroyFontCall, font);
+    return;
+  }
+
+  // Rotate the text queue once, freeing the texts using it
+  register unsigned int itr, count = queueSize(texts);
+  for (itr = 0; itr < count; itr++) {
+    Text* text = dequeue(texts);
+    if (text -> font == font)
+      freeText(text);
+    else
+      enqueue(texts, text);
+  }
+  textsChanged = true;
+
+  // Rotate the font queue once, dropping the font
+  count = queueSize(fonts);
+  for (itr = 0; itr < count; itr++) {
+    Font* other = dequeue(fonts);
+    if (other != font)
+      enqueue(fonts, other);
+  }
+
+  // Delete the atlas (GL keeps it alive for any draw still using it) and free the font
+  glDeleteTextures(1, &(font -> texture));
+  trackMemory(MEMORY_GL_TEXTURES, -(long long) (font -> width) * (font -> height));
+  trackMemory(MEMORY_TEXT, -(long long) sizeof(Font));
+  memFree(font);
+  requestFrame();
+}
+
+/**
+ * @brief Lays out a text's glyphs relative to its position
+ * 
+ * @param text The text
+ */
+static void layoutText(Text* text) {
+  // Grow the vertices to fit every glyph
+  unsigned int length = (unsigned int) strlen(text -> string);
+  if (text -> capacity < length * 6) {
+    GlyphVertex* vertices = (GlyphVertex*) memRealloc(text -> vertices, sizeof(GlyphVertex) * length * 6);
+    if (!vertices)
+      error("Failed to grow text!");
+    trackMemory(MEMORY_TEXT, (long long) sizeof(GlyphVertex) * (length * 6 - text -> capacity));
+    text -> vertices = vertices;
+    text -> capacity = length * 6;
+  }
+
+  // Size the glyphs at the same scale as entity vertices, keeping the cell's aspect
+  const Font* font = text -> font;
+  float height = (text -> size) * (1.0f / 15.0f);
+  float width = (text -> size) * (font -> cellWidth) / (font -> cellHeight) * (1.0f / 20.0f);
+  float u = (float) (font -> cellWidth) / (font -> width);
+  float v = (float) (font -> cellHeight) / (font -> height);
+
+  // Emit two triangles per visible glyph, wrapping at newlines
+  float x = 0.0f, y = 0.0f;
+  register unsigned int itr;
+  text -> count = 0;
+  for (itr = 0; itr < length; itr++) {
+    unsigned char character = (unsigned char) text -> string[itr];
+    if (character == '\n') {
+      x = 0.0f;
+      y -= height;
+      continue;
+    }
+    if (character == ' ') {
+      x += width;
+      continue;
+    }
+
+    // Draw characters missing from the sheet as '?'
+    unsigned int glyph = character >= FONT_FIRST && character < FONT_FIRST + FONT_GLYPHS ? character - FONT_FIRST : '?' - FONT_FIRST;
+    float left = (glyph % FONT_COLUMNS) * u;
+    float top = 1.0f - (glyph / FONT_COLUMNS) * v;
+    const float corners[6][4] = {
+      { x, y, left, top - v }, { x + width, y, left + u, top - v }, { x + width, y + height, left + u, top },
+      { x, y, left, top - v }, { x + width, y + height, left + u, top }, { x, y + height, left, top }
+    };
+    register unsigned int corner;
+    for (corner = 0; corner < 6; corner++) {
+      GlyphVertex* vertex = &(text -> vertices[(text -> count)++]);
+      vertex -> position[0] = corners[corner][0];
+      vertex -> position[1] = corners[corner][1];
+      vertex -> coordinates[0] = corners[corner][2];
+      vertex -> coordinates[1] = corners[corner][3];
+    }
+    x += width;
+  }
+}
+
+/**
+ * @brief Creates a text (render call)
+ * 
+ * @param data The arguments of createText() and a pointer to its result
+ */
+static void createTextCall(void* data) {
+  void** args = (void**) data;
+  *(Text**) args[5] = createText((Font*) args[0], (const char*) args[1], (float*) args[2], *(float*) args[3], (const float*) args[4]);
+}
+
+/**
+ * @brief Creates a text
+ * 
+ * @param font The font
+ * @param string The string (newlines start a new line)
+ * @param position The bottom-left corner of the first line
+ * @param size The glyph height (in the same units as entity dimensions)
+ * @param color The RGBA color (0 to 1), NULL for white
+ * @return A pointer to the text
+ */
+Text* createText(Font* font, const char* string, float position[3], float size, const float color[4]) {
+  // Verify the font, string and position
+  if (!font || !string || !position)
+    return NULL;
+
+  // Texts belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    Text* text = NULL;
+    void* args[6] = { font, (void*) string, position, &size, (void*) color, &text };
+    renderCall(createTextCall, args);
+    return text;
+  }
+
+  // Create the text
+  Text* text = (Text*) memCalloc(1, sizeof(Text));
+  if (!text)
+    error("Failed to allocate text!");
+  text -> font = font;
+  text -> string = memStrdup(string);
+  if (!(text -> string))
+    error("Failed to allocate text!");
+  memcpy(text -> position, position, sizeof(text -> position));
+  text -> size = size;
+  register unsigned int itr;
+  for (itr = 0; itr < 4; itr++)
+    text -> color[itr] = color ? (unsigned char) (255.0f * (color[itr] < 0.0f ? 0.0f : color[itr] > 1.0f ? 1.0f : color[itr]) + 0.5f) : 255;
+  trackMemory(MEMORY_TEXT, sizeof(Text) + strlen(string) + 1);
+
+  layoutText(text);
+  enqueue(texts, text);
+  textsChanged = true;
+  requestFrame();
+  return text;
+}
+
+/**
+ * @brief Changes a text's string (render call)
+ * 
+ * @param data The arguments of setText()
+ */
+static void setTextCall(void* data) {
+  void** args = (void**) data;
+  setText((Text*) args[0], (const char*) args[1]);
+}
+
+/**
+ * @brief Changes a text's string (nothing happens if it's the same string)
+ * 
+ * @param text The text
+ * @param string The new string
+ */
+void setText(Text* text, const char* string) {
+  // Verify that the text and string exist
+  if (!text || !string)
+    return;
+
+  // Texts belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    void* args[2] = { text, (void*) string };
+    renderCall(setTextCall, args);
+    return;
+  }
+
+  // Keep the layout if the string hasn't changed
+  if (strcmp(text -> string, string) == 0)
+    return;
+
+  // Replace the string and lay it out again
+  char* copy = memStrdup(string);
+  if (!copy)
+    error("Failed to allocate text!");
+  trackMemory(MEMORY_TEXT, (long long) strlen(string) - (long long) strlen(text -> string));
+  memFree(text -> string);
+  text -> string = copy;
+  layoutText(text);
+  textsChanged = true;
+  requestFrame();
+}
+
+/**
+ * @brief Moves a text (render call)
+ * 
+ * @param data The arguments of moveText()
+ */
+static void moveTextCall(void* data) {
+  void** args = (void**) data;
+  moveText((Text*) args[0], (float*) args[1]);
+}
+
+/**
+ * @brief Moves a text
+ * 
+ * @param text The text
+ * @param delta The change in position
+ */
+void moveText(Text* text, float delta[3]) {
+  // Verify that the text and delta exist
+  if (!text || !delta)
+    return;
+
+  // Texts belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    void* args[2] = { text, delta };
+    renderCall(moveTextCall, args);
+    return;
+  }
+
+  // Only the batch changes (the layout is relative to the position)
+  text -> position[0] += delta[0];
+  text -> position[1] += delta[1];
+  text -> position[2] += delta[2];
+  textsChanged = true;
+  requestFrame();
+}
+
+/**
+ * @brief Destroys a text (render call)
+ * 
+ * @param data The text
+ */
+static void destroyTextCall(void* data) {
+  destroyText((Text*) data);
+}
+
+/**
+ * @brief Destroys a text
+ * 
+ * @param text The text
+ */
+void destroyText(Text* text) {
+  // Verify that the text exists
+  if (!text)
+    return;
+
+  // Texts belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    renderCall(destroyTextCall, text);
+    return;
+  }
+
+  // Rotate the text queue once, dropping the text
+  register unsigned int itr, count = queueSize(texts);
+  for (itr = 0; itr < count; itr++) {
+    Text* other = dequeue(texts);
+    if (other != text)
+      enqueue(texts, other);
+  }
+  textsChanged = true;
+  requestFrame();
+  freeText(text);
+}
+
+/**
+ * @brief Gathers every text's glyphs into the batch, grouped by font, and uploads it
+ */
+static void batchTexts(void) {
+  // Grow the batch to fit every glyph
+  unsigned int size = 0;
+  QueueIterator itr = iterateQueue(texts);
+  Text* text;
+  while ((text = nextElement(&itr)))
+    size += text -> count;
+  if (textBatchCapacity < size) {
+    GlyphVertex* batch = (GlyphVertex*) memRealloc(textBatch, sizeof(GlyphVertex) * size);
+    if (!batch)
+      error("Failed to grow text batch!");
+    trackMemory(MEMORY_TEXT, (long long) sizeof(GlyphVertex) * (size - textBatchCapacity));
+    textBatch = batch;
+    textBatchCapacity = size;
+  }
+
+  // Place each font's texts together so the font draws with one call
+  unsigned int count = 0;
+  QueueIterator sheets = iterateQueue(fonts);
+  Font* font;
+  while ((font = nextElement(&sheets))) {
+    font -> first = count;
+    itr = iterateQueue(texts);
+    while ((text = nextElement(&itr))) {
+      if (text -> font != font)
+        continue;
+      register unsigned int vertex;
+      for (vertex = 0; vertex < text -> count; vertex++) {
+        GlyphVertex* out = &textBatch[count++];
+        out -> position[0] = text -> position[0] + text -> vertices[vertex].position[0];
+        out -> position[1] = text -> position[1] + text -> vertices[vertex].position[1];
+        out -> position[2] = text -> position[2];
+        out -> coordinates[0] = text -> vertices[vertex].coordinates[0];
+        out -> coordinates[1] = text -> vertices[vertex].coordinates[1];
+        memcpy(out -> color, text -> color, sizeof(out -> color));
+      }
+    }
+    font -> count = count - font -> first;
+  }
+
+  // Upload into freshly orphaned storage, growing it if needed
+  glBindBuffer(GL_ARRAY_BUFFER, textBuffer);
+  if (textBufferCapacity < count) {
+    trackMemory(MEMORY_GL_BUFFERS, (long long) sizeof(GlyphVertex) * (count - textBufferCapacity));
+    textBufferCapacity = count;
+  }
+  glBufferData(GL_ARRAY_BUFFER, sizeof(GlyphVertex) * textBufferCapacity, NULL, GL_DYNAMIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GlyphVertex) * count, textBatch);
+  stats.uploadBytes += sizeof(GlyphVertex) * count;
+  textsChanged = false;
+}
+
+/**
+ * @brief Draws every text with one call per font
+ * 
+ * @return The number of draw calls
+ */
+static unsigned int drawTexts(void) {
+  // Rebuild the batch only if a text changed (unchanged text uploads nothing)
+  if (!textProgram || isEmpty(texts))
+    return 0;
+  if (textsChanged)
+    batchTexts();
+
+  // Blend the glyph coverage over the scene
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glUseProgram(textProgram);
+  glBindVertexArray(textArray);
+  glActiveTexture(GL_TEXTURE0);
+
+  unsigned int draws = 0;
+  QueueIterator itr = iterateQueue(fonts);
+  Font* font;
+  while ((font = nextElement(&itr))) {
+    if (font -> count == 0)
+      continue;
+    glBindTexture(GL_TEXTURE_2D, font -> texture);
+    glDrawArrays(GL_TRIANGLES, font -> first, font -> count);
+    stats.glyphs += font -> count / 6;
+    draws++;
+  }
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDisable(GL_BLEND);
+
+  return draws;
+}
+
+/**
+ * @brief Show or hide the performance HUD
+ * 
+ * @param visible Whether the HUD is drawn
+ */
+void setHUD(bool visible) {
+  SDL_AtomicSet(&(hud.visible), visible);
+  requestFrame();
+}
+
+/**
+ * @brief Toggle the performance HUD
+ */
+void toggleHUD(void) {
+  setHUD(!SDL_AtomicGet(&(hud.visible)));
+}
+
+/**
+ * @brief Writes a solid quad of the HUD
+ * 
+ * @param vertex The first of the quad's six vertices
+ * @param left The left edge
+ * @param bottom The bottom edge
+ * @param right The right edge
+ * @param top The top edge
+ * @param color The RGBA color
+ * @return The vertex after the quad
+ */
+static GlyphVertex* hudQuad(GlyphVertex* vertex, float left, float bottom, float right, float top, const unsigned char color[4]) {
+  // Sample the middle of the built-in font's solid glyph (DEL)
+  const Font* font = hud.font;
+  unsigned int glyph = FONT_GLYPHS - 1;
+  float u = ((glyph % FONT_COLUMNS) * (font -> cellWidth) + 2.5f) / (font -> width);
+  float v = 1.0f - ((glyph / FONT_COLUMNS) * (font -> cellHeight) + 3.5f) / (font -> height);
+
+  const float corners[6][2] = { { left, bottom }, { right, bottom }, { right, top }, { left, bottom }, { right, top }, { left, top } };
+  register unsigned int corner;
+  for (corner = 0; corner < 6; corner++, vertex++) {
+    vertex -> position[0] = corners[corner][0];
+    vertex -> position[1] = corners[corner][1];
+    vertex -> position[2] = 0.0f;
+    vertex -> coordinates[0] = u;
+    vertex -> coordinates[1] = v;
+    memcpy(vertex -> color, color, sizeof(vertex -> color));
+  }
+
+  return vertex;
+}
+
+/**
+ * @brief Draws the performance HUD over the finished frame with a single call
+ */
+static void drawHUD(void) {
+  // Forget the frame history while hidden
+  Uint64 start = SDL_GetPerformanceCounter();
+  double frequency = (double) SDL_GetPerformanceFrequency();
+  if (!SDL_AtomicGet(&(hud.visible))) {
+    hud.last = 0;
+    return;
+  }
+
+  // Keep the counters refreshing while a lazy loop idles
+  requestFrameAfter((unsigned int) (HUD_REFRESH * 1000.0));
+
+  // Record the time since the last frame
+  if (hud.last) {
+    hud.times[hud.head] = (float) ((start - hud.last) * 1000.0 / frequency);
+    hud.head = (hud.head + 1) % HUD_FRAMES;
+  }
+  hud.last = start;
+
+  // Create the built-in font and the HUD's buffer the first time it's shown
+  if (!hud.font) {
+    hud.font = createFont(NULL, 0, 0);
+    hud.text.font = hud.font;
+    hud.text.string = hud.string;
+    hud.text.size = HUD_SIZE;
+    glGenVertexArrays(1, &(hud.vao));
+    glGenBuffers(1, &(hud.vbo));
+    glBindVertexArray(hud.vao);
+    glBindBuffer(GL_ARRAY_BUFFER, hud.vbo);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (void*) offsetof(GlyphVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphVertex), (void*) offsetof(GlyphVertex, coordinates));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(GlyphVertex), (void*) offsetof(GlyphVertex, color));
+    glEnableVertexAttribArray(2);
+    glBindVertexArray(0);
+  }
+
+  // Refresh the counters a few times a second (laying out text every frame would cost more than the rest)
+  float budget = scaler.budget > 0.0f ? scaler.budget : 1000.0f / 60.0f;
+  register unsigned int itr;
+  if (!(hud.refreshed) || start - hud.refreshed >= (Uint64) (frequency * HUD_REFRESH)) {
+    hud.refreshed = start;
+    float total = 0.0f, worst = 0.0f;
+    unsigned int frames = 0;
+    for (itr = 0; itr < HUD_FRAMES; itr++) {
+      if (hud.times[itr] <= 0.0f)
+        continue;
+      total += hud.times[itr];
+      worst = hud.times[itr] > worst ? hud.times[itr] : worst;
+      frames++;
+    }
+    float average = frames ? total / frames : 0.0f;
+    MemoryStats memory = getMemoryStats(MEMORY_TAGS);
+    long long video = getMemoryStats(MEMORY_GL_BUFFERS).current + getMemoryStats(MEMORY_GL_TEXTURES).current;
+    int length = snprintf(hud.string, sizeof(hud.string),
+      "FPS %.0f  %.2f ms (worst %.2f)\ndraws %u  entities %u  particles %u\nuploads %u  %.1f KB\nmemory %.1f MB (peak %.1f)  gpu %.1f MB\n",
+      average > 0.0f ? 1000.0f / average : 0.0f, average, worst, stats.drawCalls, stats.entities, stats.particles,
+      stats.uploads, stats.uploadBytes / 1024.0, memory.current / 1048576.0, memory.peak / 1048576.0, video / 1048576.0);
+    if (length > 0 && (size_t) length < sizeof(hud.string))
+      snprintf(hud.string + length, sizeof(hud.string) - length, scaler.enabled ? "hud %.3f ms  scene gpu %.2f ms" : "hud %.3f ms", hud.cost, scaler.gpuTime);
+    for (hud.lines = 1, itr = 0; hud.string[itr]; itr++)
+      hud.lines += hud.string[itr] == '\n';
+    layoutText(&(hud.text));
+  }
+
+  // Grow the scratch and buffer to fit the panel, the counters and a bar per frame
+  unsigned int count = 6 + hud.text.count + HUD_FRAMES * 6;
+  if (hud.capacity < count) {
+    GlyphVertex* vertices = (GlyphVertex*) memRealloc(hud.vertices, sizeof(GlyphVertex) * count);
+    if (!vertices)
+      error("Failed to grow HUD!");
+    trackMemory(MEMORY_TEXT, (long long) sizeof(GlyphVertex) * (count - hud.capacity));
+    trackMemory(MEMORY_GL_BUFFERS, (long long) sizeof(GlyphVertex) * (count - hud.capacity));
+    hud.vertices = vertices;
+    hud.capacity = count;
+  }
+
+  // Lay out the panel in the top-left corner, the counters, then the graph below them
+  static const unsigned char panel[4] = { 0, 0, 0, 160 }, white[4] = { 255, 255, 255, 255 };
+  static const unsigned char under[4] = { 64, 224, 96, 255 }, over[4] = { 240, 64, 48, 255 };
+  float line = HUD_SIZE * (1.0f / 15.0f), margin = line * 0.5f;
+  float left = -1.0f + margin, top = 1.0f - margin;
+  float graph = top - line * (hud.lines) - margin;
+  float right = left + HUD_GRAPH_WIDTH;
+  for (itr = 0; itr < hud.text.count; itr++)
+    if (left + hud.text.vertices[itr].position[0] > right)
+      right = left + hud.text.vertices[itr].position[0];
+  GlyphVertex* vertex = hudQuad(hud.vertices, -1.0f, graph - HUD_GRAPH_HEIGHT - margin, right + margin, 1.0f, panel);
+  for (itr = 0; itr < hud.text.count; itr++, vertex++) {
+    *vertex = hud.text.vertices[itr];
+    vertex -> position[0] += left;
+    vertex -> position[1] += top - line;
+    vertex -> position[2] = 0.0f;
+    memcpy(vertex -> color, white, sizeof(vertex -> color));
+  }
+
+  // Draw the frame times oldest first, scaled so twice the budget fills the graph
+  float width = HUD_GRAPH_WIDTH / HUD_FRAMES;
+  for (itr = 0; itr < HUD_FRAMES; itr++) {
+    float time = hud.times[(hud.head + itr) % HUD_FRAMES];
+    float height = time / (budget * 2.0f);
+    height = HUD_GRAPH_HEIGHT * (height > 1.0f ? 1.0f : height);
+    vertex = hudQuad(vertex, left + width * itr, graph - HUD_GRAPH_HEIGHT, left + width * (itr + 1), graph - HUD_GRAPH_HEIGHT + height, time > budget ? over : under);
+  }
+
+  // Upload into freshly orphaned storage and draw everything with one call
+  glBindBuffer(GL_ARRAY_BUFFER, hud.vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(GlyphVertex) * hud.capacity, NULL, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GlyphVertex) * count, hud.vertices);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glUseProgram(textProgram);
+  glBindVertexArray(hud.vao);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, hud.font -> texture);
+  glDrawArrays(GL_TRIANGLES, 0, count);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glDisable(GL_BLEND);
+
+  // Report the HUD's own time (on the CPU; its GPU work is one small draw)
+  hud.cost = (float) ((SDL_GetPerformanceCounter() - start) * 1000.0 / frequency);
+  stats.hudTime = hud.cost;
+}
+
+/**
+ * @brief Saves every entity and shader to a scene file (render call)
+ * 
+ * @param data The filename and a pointer to the result
+ */
+static void saveSceneCall(void* data) {
+  void** args = (void**) data;
+  *(bool*) args[1] = saveScene((const char*) args[0]);
+}
+
+/**
+ * @brief Appends a string to a scene's string table, reusing an equal one already in it
+ * 
+ * @param table The string table
+ * @param size The size of the table
+ * @param capacity The capacity of the table
+ * @param string The string
+ * @param shared Whether an equal string may be reused (filenames)
+ * @return The offset of the string in the table
+ */
+static uint32_t appendSceneString(char** table, size_t* size, size_t* capacity, const char* string, bool shared) {
+  // Reuse an equal filename (scenes use few distinct shader files)
+  size_t length = strlen(string) + 1, offset;
+  if (shared)
+    for (offset = 0; offset < *size; offset += strlen(*table + offset) + 1)
+      if (strcmp(*table + offset, string) == 0)
+        return (uint32_t) offset;
+
+  // Grow the table if it's full
+  if (*size + length > *capacity) {
+    size_t grown = *capacity ? *capacity : 4096;
+    while (grown < *size + length)
+      grown <<= 1;
+    char* strings = (char*) memRealloc(*table, grown);
+    if (!strings)
+      error("Failed to grow scene strings!");
+    *table = strings;
+    *capacity = grown;
+  }
+  memcpy(*table + *size, string, length);
+  *size += length;
+  return (uint32_t) (*size - length);
+}
+
+/**
+ * @brief Saves every entity and shader to a scene file
+ * 
+ * @param filename The scene filename
+ * @return true if the scene was written
+ */
+bool saveScene(const char* filename) {
+  // Verify the filename
+  if (!filename)
+    return false;
+
+  // The shader queue belongs to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    bool saved = false;
+    void* args[2] = { (void*) filename, &saved };
+    renderCall(saveSceneCall, args);
+    return saved;
+  }
+
+  // Gather the living entities, numbering them by hash map slot
+  updateTransforms();
+  Entity* block = (Entity*) memAlloc(sizeof(Entity) * MAP_MAX);
+  uint32_t* indices = (uint32_t*) memCalloc(MAP_MAX, sizeof(uint32_t));
+  SceneShader* records = (SceneShader*) memAlloc(sizeof(SceneShader) * (queueSize(shaders) + 1));
+  char* strings = NULL;
+  size_t size = 0, capacity = 0;
+  if (!block || !indices || !records)
+    error("Failed to allocate scene!");
+  appendSceneString(&strings, &size, &capacity, "", false);
+  uint32_t count = 0;
+  register unsigned int itr;
+  for (itr = 0; itr < MAP_MAX; itr++) {
+    Entity* entity = (Entity*) entities[itr];
+    if (!entity)
+      continue;
+    indices[itr] = ++count;
+    block[count - 1] = *entity;
+    block[count - 1].ID = (const char*) (uintptr_t) appendSceneString(&strings, &size, &capacity, entity -> ID, false);
+    block[count - 1].version = 0;
+    block[count - 1].proxy = 0;
+    block[count - 1].scene = NULL;
+    block[count - 1].shaders = NULL;
+    block[count - 1].children = 0;
+    block[count - 1].node = 0;
+    block[count - 1].depth = 0;
+    block[count - 1].moved = 0;
+    block[count - 1].dirty = false;
+  }
+
+  // Store the parents as indices (every parent is alive, as destroying one detaches its children)
+  for (itr = 0; itr < count; itr++)
+    if (block[itr].parent)
+      block[itr].parent = (Entity*) (uintptr_t) indices[hash(block[itr].parent -> ID)];
+
+  // Record every shader whose entity is alive
+  uint32_t shaderCount = 0;
+  QueueIterator queue = iterateQueue(shaders);
+  Shader* shader;
+  while ((shader = nextElement(&queue))) {
+    if (!(shader -> entity))
+      continue;
+    unsigned int slot = hash(shader -> entityID);
+    if (!indices[slot] || strcmp(((Entity*) entities[slot]) -> ID, shader -> entityID) != 0)
+      continue;
+    records[shaderCount].entity = indices[slot] - 1;
+    records[shaderCount].vertFile = appendSceneString(&strings, &size, &capacity, shader -> vertFile, true);
+    records[shaderCount++].fragFile = appendSceneString(&strings, &size, &capacity, shader -> fragFile, true);
+  }
+
+  // Lay out the arrays, pointing the strings past the records
+  SceneHeader header = { "NANISCEN", SCENE_VERSION, sizeof(Entity), count, shaderCount, 0, 0, 0 };
+  header.entityOffset = (sizeof(SceneHeader) + SCENE_ALIGNMENT - 1) & ~(uint64_t) (SCENE_ALIGNMENT - 1);
+  header.shaderOffset = (header.entityOffset + sizeof(Entity) * count + SCENE_ALIGNMENT - 1) & ~(uint64_t) (SCENE_ALIGNMENT - 1);
+  header.stringOffset = header.shaderOffset + sizeof(SceneShader) * shaderCount;
+  for (itr = 0; itr < count; itr++)
+    block[itr].ID = (const char*) ((uintptr_t) block[itr].ID + header.stringOffset);
+  for (itr = 0; itr < shaderCount; itr++) {
+    records[itr].vertFile += (uint32_t) header.stringOffset;
+    records[itr].fragFile += (uint32_t) header.stringOffset;
+  }
+
+  // Write the scene
+  static const unsigned char padding[SCENE_ALIGNMENT];
+  bool success = header.stringOffset + size <= UINT32_MAX;
+  FILE* file = success ? fopen(filename, "wb") : NULL;
+  if (!file)
+    fprintf(stderr, success ? "Error: Could not open file.\n" : "Error: Scene is too large.\n");
+  else {
+    fwrite(&header, sizeof(header), 1, file);
+    fwrite(padding, (size_t) (header.entityOffset - sizeof(header)), 1, file);
+    fwrite(block, sizeof(Entity), count, file);
+    fwrite(padding, (size_t) (header.shaderOffset - header.entityOffset - sizeof(Entity) * count), 1, file);
+    fwrite(records, sizeof(SceneShader), shaderCount, file);
+    fwrite(strings, size, 1, file);
+    success = !ferror(file);
+    if (!success)
+      fprintf(stderr, "Error: Could not write to file.\n");
+    fclose(file);
+  }
+
+  memFree(block);
+  memFree(indices);
+  memFree(records);
+  memFree(strings);
+  return file && success;
+}
+
+/**
+ * @brief Loads a scene file (render call)
+ * 
+ * @param data The filename and a pointer to the result
+ */
+static void loadSceneCall(void* data) {
+  void** args = (void**) data;
+  *(Scene**) args[1] = loadScene((const char*) args[0]);
+}
+
+/**
+ * @brief Loads a scene file, creating its entities and shaders
+ *
+ * The entities are copied out of the mapped file in one block and keep
+ * pointing into it for their ids, so nothing is parsed or allocated per
+ * entity. Each distinct pair of shader files is compiled once; later shaders
+ * load the linked program binary when the driver supports it.
+ * 
+ * @param filename The scene filename
+ * @return A pointer to the scene, NULL if it couldn't be loaded
+ */
+Scene* loadScene(const char* filename) {
+  // Verify the filename
+  if (!filename)
+    return NULL;
+
+  // GL objects can only be created on the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    Scene* scene = NULL;
+    void* args[2] = { (void*) filename, &scene };
+    renderCall(loadSceneCall, args);
+    return scene;
+  }
+  Uint64 start = SDL_GetPerformanceCounter();
+
+  // Map the scene
+  Scene* scene = (Scene*) memCalloc(1, sizeof(Scene));
+  if (!scene)
+    return NULL;
+  scene -> data = mapFile(filename, &(scene -> size), &(scene -> mapped));
+  trackMemory(MEMORY_ASSETS, sizeof(Scene) + scene -> size);
+
+  // Verify the header, that every array is inside the file and that the strings are terminated
+  const SceneHeader* header = (const SceneHeader*) scene -> data;
+  if (!(scene -> data) || scene -> size < sizeof(SceneHeader) || memcmp(header -> magic, "NANISCEN", 8) != 0 || header -> version != SCENE_VERSION || header -> entitySize != sizeof(Entity)
+      || header -> entityOffset + (uint64_t) sizeof(Entity) * (header -> entities) > header -> shaderOffset
+      || header -> shaderOffset + (uint64_t) sizeof(SceneShader) * (header -> shaders) > header -> stringOffset
+      || header -> stringOffset >= scene -> size || scene -> data[scene -> size - 1] != '\0') {
+    fprintf(stderr, "Error: Invalid scene \"%s\".\n", filename);
+    unloadScene(scene);
+    return NULL;
+  }
+
+  // Copy the entities out in one block
+  scene -> count = header -> entities;
+  scene -> entities = (Entity*) memAlloc(sizeof(Entity) * (scene -> count ? scene -> count : 1));
+  if (!(scene -> entities))
+    error("Failed to allocate scene!");
+  memcpy(scene -> entities, scene -> data + header -> entityOffset, sizeof(Entity) * (scene -> count));
+  trackMemory(MEMORY_ENTITIES, (long long) sizeof(Entity) * (scene -> count));
+
+  // Point every entity at its id and register it (entities whose id or slot is taken are left out)
+  register unsigned int itr, leftOut = 0;
+  for (itr = 0; itr < scene -> count; itr++) {
+    Entity* entity = &(scene -> entities[itr]);
+    uintptr_t id = (uintptr_t) entity -> ID;
+    entity -> ID = NULL;
+    entity -> version = 0;
+    entity -> scene = scene;
+    entity -> shaders = NULL;
+    entity -> parent = NULL;
+    entity -> children = entity -> node = 0;
+    entity -> dirty = false;
+    if (id < header -> stringOffset || id >= scene -> size || search(entities, (char*) (scene -> data + id))) {
+      leftOut++;
+      continue;
+    }
+    entity -> ID = (const char*) (scene -> data + id);
+    insert(entities, (char*) entity -> ID, entity);
+    addProxy(entity);
+  }
+  if (leftOut)
+    fprintf(stderr, "Error: Left %u of %u entities out of scene \"%s\", their ids or slots are taken.\n", leftOut, scene -> count, filename);
+
+  // Reattach the children to their parents (an entity left out takes its children's links with it)
+  const Entity* images = (const Entity*) (scene -> data + header -> entityOffset);
+  for (itr = 0; itr < scene -> count; itr++) {
+    uintptr_t parent = (uintptr_t) images[itr].parent;
+    Entity* entity = &(scene -> entities[itr]);
+    if (!(entity -> ID) || !parent || parent > scene -> count || !(scene -> entities[parent - 1].ID))
+      continue;
+    Entity* ancestor;
+    for (ancestor = &(scene -> entities[parent - 1]); ancestor && ancestor != entity; ancestor = ancestor -> parent);
+    if (!ancestor)
+      attachEntity(entity, &(scene -> entities[parent - 1]));
+  }
+
+  // Make room for every shader's geometry at once when drawn by multi-draw
+  if (multiDraw && meshSlots + header -> shaders > meshCapacity) {
+    unsigned int capacity = meshCapacity ? meshCapacity : MESH_CAPACITY;
+    while (capacity < meshSlots + header -> shaders)
+      capacity <<= 1;
+    growMeshBuffers(capacity);
+  }
+
+  // Create the shaders, keeping each linked program for the shaders after it
+  programBinaries = GLEW_ARB_get_program_binary ? createQueue() : NULL;
+  const SceneShader* records = (const SceneShader*) (scene -> data + header -> shaderOffset);
+  for (itr = 0; itr < header -> shaders; itr++) {
+    const SceneShader* record = &records[itr];
+    if (record -> entity >= scene -> count || !(scene -> entities[record -> entity].ID)
+        || record -> vertFile < header -> stringOffset || record -> vertFile >= scene -> size
+        || record -> fragFile < header -> stringOffset || record -> fragFile >= scene -> size)
+      continue;
+    createShader((char*) scene -> entities[record -> entity].ID, (const char*) (scene -> data + record -> vertFile), (const char*) (scene -> data + record -> fragFile));
+  }
+  if (programBinaries) {
+    ProgramBinary* binary;
+    while ((binary = dequeue(programBinaries))) {
+      memFree(binary -> data);
+      memFree(binary);
+    }
+    freeQueue(programBinaries);
+    programBinaries = NULL;
+  }
+
+  recordLoadMetrics(LOAD_SCENE, start);
+  requestFrame();
+  return scene;
+}
+
+/**
+ * @brief Unloads a scene (render call)
+ * 
+ * @param data The scene
+ */
+static void unloadSceneCall(void* data) {
+  unloadScene((Scene*) data);
+}
+
+/**
+ * @brief Destroys a scene's remaining entities (and their shaders) and unmaps it
+ * 
+ * @param scene The scene
+ */
+void unloadScene(Scene* scene) {
+  // Verify that the scene exists
+  if (!scene)
+    return;
+
+  // Shaders belong to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    renderCall(unloadSceneCall, scene);
+    return;
+  }
+
+  // Destroy the entities that are still alive
+  register unsigned int itr;
+  for (itr = 0; itr < scene -> count; itr++) {
+    Entity* entity = &(scene -> entities[itr]);
+    if (entity -> ID && search(entities, (char*) entity -> ID) == entity)
+      destroyEntity((char*) entity -> ID);
+  }
+
+  // Free the block and unmap the file
+  trackMemory(MEMORY_ENTITIES, -(long long) sizeof(Entity) * (scene -> count));
+  trackMemory(MEMORY_ASSETS, -(long long) (sizeof(Scene) + scene -> size));
+  memFree(scene -> entities);
+  if (scene -> data)
+    unmapFile(scene -> data, scene -> size, scene -> mapped);
+  memFree(scene);
+}
+
+/**
+ * @brief Resizes (or with a zero size, deletes) the render target
+ * 
+ * @param width The new width
+ * @param height The new height
+ */
+static void resizeSceneTarget(int width, int height) {
+  // Release the previous target
+  if (scaler.framebuffer) {
+    glDeleteFramebuffers(1, &(scaler.framebuffer));
+    glDeleteRenderbuffers(1, &(scaler.color));
+    glDeleteRenderbuffers(1, &(scaler.depth));
+    trackMemory(MEMORY_GL_TEXTURES, -8LL * (scaler.width) * (scaler.height));
+    scaler.framebuffer = scaler.color = scaler.depth = 0;
+  }
+  scaler.width = width;
+  scaler.height = height;
+  if (width <= 0 || height <= 0)
+    return;
+
+  // Create the color and depth attachments
+  glGenRenderbuffers(1, &(scaler.color));
+  glBindRenderbuffer(GL_RENDERBUFFER, scaler.color);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+  glGenRenderbuffers(1, &(scaler.depth));
+  glBindRenderbuffer(GL_RENDERBUFFER, scaler.depth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, width, height);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+  trackMemory(MEMORY_GL_TEXTURES, 8LL * width * height);
+
+  // Attach them to the framebuffer
+  glGenFramebuffers(1, &(scaler.framebuffer));
+  glBindFramebuffer(GL_FRAMEBUFFER, scaler.framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, scaler.color);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, scaler.depth);
+  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+    error("Failed to create render target!");
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/**
+ * @brief Enables or disables dynamic resolution (render call)
+ * 
+ * @param data The arguments of setDynamicResolution()
+ */
+static void dynamicResolutionCall(void* data) {
+  void** args = (void**) data;
+  setDynamicResolution(*(bool*) args[0], *(int*) args[1]);
+}
+
+/**
+ * @brief Render into a scaled target that adapts to the measured frame time, upscaled to the window
+ * 
+ * @param enabled Whether to scale the resolution
+ * @param fps The frame rate to hold
+ */
+void setDynamicResolution(bool enabled, int fps) {
+  // The render target belongs to the thread owning the context
+  if (renderThread && SDL_ThreadID() != renderThreadID) {
+    void* args[2] = { &enabled, &fps };
+    renderCall(dynamicResolutionCall, args);
+    return;
+  }
+
+  // Update the frame budget
+  scaler.budget = 1000.0f / (fps > 0 ? fps : 60);
+  if (enabled == scaler.enabled)
+    return;
+
+  // Create the timer queries, or release everything
+  scaler.enabled = enabled;
+  if (enabled) {
+    glGenQueries(TIMER_QUERIES, scaler.queries);
+    scaler.gpuTime = scaler.cpuTime = 0.0f;
+    scaler.over = scaler.under = 0;
+  }
+  else {
+    glDeleteQueries(TIMER_QUERIES, scaler.queries);
+    memset(scaler.queries, 0, sizeof(scaler.queries));
+    memset(scaler.pending, 0, sizeof(scaler.pending));
+    resizeSceneTarget(0, 0);
+    scaler.scale = 1.0f;
+    scaler.drawableWidth = scaler.drawableHeight = 0;
+  }
+}
+
+/**
+ * @brief Get the current render scale
+ * 
+ * @return The render target's share of the window, per axis (1 without dynamic resolution)
+ */
+float getResolutionScale(void) {
+  return scaler.scale;
+}
+
+/**
+ * @brief Binds the render target for a frame, following the drawable size
+ * 
+ * @param window The window being rendered to
+ */
+static void beginScene(SDL_Window* window) {
+  // Follow the drawable (resizing only touches the viewport and the target, never geometry)
+  int width, height;
+  SDL_GL_GetDrawableSize(window, &width, &height);
+  bool resized = width != scaler.drawableWidth || height != scaler.drawableHeight;
+  scaler.drawableWidth = width;
+  scaler.drawableHeight = height;
+  if (!(scaler.enabled)) {
+    if (resized)
+      glViewport(0, 0, width, height);
+    return;
+  }
+  scaler.start = SDL_GetPerformanceCounter();
+
+  // Size the render target to the scaled drawable
+  int targetWidth = (int) (width * scaler.scale + 0.5f), targetHeight = (int) (height * scaler.scale + 0.5f);
+  if (targetWidth < 1)
+    targetWidth = 1;
+  if (targetHeight < 1)
+    targetHeight = 1;
+  if (targetWidth != scaler.width || targetHeight != scaler.height)
+    resizeSceneTarget(targetWidth, targetHeight);
+  glBindFramebuffer(GL_FRAMEBUFFER, scaler.framebuffer);
+  glViewport(0, 0, targetWidth, targetHeight);
+
+  // Collect the oldest timing (a few frames old, so it never stalls) and reuse its query
+  GLuint query = scaler.queries[scaler.query];
+  if (scaler.pending[scaler.query]) {
+    GLint available = 0;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available) {
+      GLuint64 elapsed;
+      glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+      scaler.gpuTime += (elapsed / 1000000.0f - scaler.gpuTime) * 0.1f;
+      scaler.pending[scaler.query] = false;
+    }
+  }
+  scaler.timing = !(scaler.pending[scaler.query]);
+  if (scaler.timing)
+    glBeginQuery(GL_TIME_ELAPSED, query);
+}
+
+/**
+ * @brief Upscales the render target to the backbuffer and adapts the render scale
+ */
+static void endScene(void) {
+  if (!(scaler.enabled))
+    return;
+
+  // Finish timing the scene
+  if (scaler.timing) {
+    glEndQuery(GL_TIME_ELAPSED);
+    scaler.pending[scaler.query] = true;
+    scaler.query = (scaler.query + 1) % TIMER_QUERIES;
+  }
+  float cpuTime = (SDL_GetPerformanceCounter() - scaler.start) * 1000.0f / SDL_GetPerformanceFrequency();
+  scaler.cpuTime += (cpuTime - scaler.cpuTime) * 0.1f;
+
+  // Upscale the target into the backbuffer with a single blit
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, scaler.framebuffer);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+  glBlitFramebuffer(0, 0, scaler.width, scaler.height, 0, 0, scaler.drawableWidth, scaler.drawableHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glViewport(0, 0, scaler.drawableWidth, scaler.drawableHeight);
+
+  // Count the frames over (GPU bound) and under the thresholds
+  if (scaler.gpuTime > scaler.budget * RESOLUTION_DOWN && scaler.gpuTime >= scaler.cpuTime) {
+    scaler.over++;
+    scaler.under = 0;
+  }
+  else if (scaler.gpuTime < scaler.budget * RESOLUTION_UP) {
+    scaler.under++;
+    scaler.over = 0;
+  }
+  else
+    scaler.over = scaler.under = 0;
+
+  // Step the scale once a condition has held long enough (recovering more slowly than backing off)
+  if (scaler.over >= RESOLUTION_FRAMES && scaler.scale > RESOLUTION_MIN) {
+    scaler.scale = fmaxf(RESOLUTION_MIN, scaler.scale - RESOLUTION_STEP);
+    scaler.over = 0;
+  }
+  else if (scaler.under >= RESOLUTION_FRAMES * 4 && scaler.scale < 1.0f) {
+    scaler.scale = fminf(1.0f, scaler.scale + RESOLUTION_STEP);
+    scaler.under = 0;
+  }
+}
+
+/**
+ * @brief Initialize OpenGL
+ */
+void initialize(void) {
+  // Initialize GLEW.
+  glewExperimental = GL_TRUE;
+  GLenum glewError = glewInit();
+  if (glewError != GLEW_OK)
+    error(strcat("GLEW Failed to Initialize!\n> ", glewGetErrorString(glewInit())));
+
+  // Initialize render field variables
+  shaders = createQueue();
+  entities = createHashMap();
+  tilemaps = createQueue();
+  emitters = createQueue();
+  fonts = createQueue();
+  texts = createQueue();
+  multiDrawPrograms = createQueue();
+  meshFree = createQueue();
+
+  // Use the multi-draw-indirect backend on GL 4.5 with draw parameters
+  #ifndef NO_NANITE_MULTIDRAW
+    GLint major = 0, minor = 0, extensions = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+    bool parameters = false;
+    register GLint extension;
+    for (extension = 0; extension < extensions && !parameters; extension++)
+      parameters = strcmp((const char*) glGetStringi(GL_EXTENSIONS, extension), "GL_ARB_shader_draw_parameters") == 0;
+    multiDraw = (major > 4 || (major == 4 && minor >= 5)) && parameters;
+    if (multiDraw) {
+      glCreateBuffers(1, &drawBuffer);
+    }
+  #endif
+
+  // Start the recorder threads, leaving a core for the main thread
+  int cores = SDL_GetCPUCount() - 1;
+  recorderCount = cores < RECORDER_MAX ? (cores > 0 ? cores : 0) : RECORDER_MAX;
+  SDL_AtomicSet(&recording, 1);
+  register unsigned int itr;
+  for (itr = 1; itr <= recorderCount; itr++) {
+    recorders[itr].start = SDL_CreateSemaphore(0);
+    recorders[itr].done = SDL_CreateSemaphore(0);
+    recorders[itr].thread = SDL_CreateThread(recordDrawLoop, "nanite-recorder", &recorders[itr]);
+    if (!recorders[itr].thread)
+      error("Failed to create recorder thread!");
+  }
+
+  // Draw the first frame (a lazy loop waits for something to change otherwise)
+  requestFrame();
+}
+
+/**
+ * @brief Release the render field variables
+ */
+void finalize(void) {
+  // Stop watching shader files
+  unwatchShaders();
+
+  // Finish the pending captures and stop the encoder thread
+  if (encoderThread) {
+    stopRecordingCall(NULL);
+    readCaptures(true);
+    SDL_AtomicSet(&encoding, 0);
+    SDL_SemPost(encoderWake);
+    SDL_WaitThread(encoderThread, NULL);
+    encoderThread = NULL;
+    SDL_DestroySemaphore(encoderWake);
+    freeSPSCQueue(captureJobs);
+    char* filename;
+    while ((filename = dequeue(captureRequests)))
+      memFree(filename);
+    freeQueue(captureRequests);
+    register unsigned int index;
+    for (index = 0; index < CAPTURE_BUFFERS; index++) {
+      glDeleteBuffers(1, &(captures[index].pbo));
+      trackMemory(MEMORY_GL_BUFFERS, -(long long) captures[index].size);
+    }
+    memset(captures, 0, sizeof(captures));
+  }
+
+  // Stop the recorder threads
+  SDL_AtomicSet(&recording, 0);
+  register unsigned int itr;
+  for (itr = 1; itr <= recorderCount; itr++) {
+    SDL_SemPost(recorders[itr].start);
+    SDL_WaitThread(recorders[itr].thread, NULL);
+    SDL_DestroySemaphore(recorders[itr].start);
+    SDL_DestroySemaphore(recorders[itr].done);
+  }
+  memset(recorders, 0, sizeof(recorders));
+  recorderCount = 0;
+
+  // Release the render target
+  setDynamicResolution(false, 0);
+
+  // Release the multi-draw staging
+  memFree(staged);
+  memFree(indirectCommands);
+  if (indirectPositions)
+    trackMemory(MEMORY_SHADERS, -(long long) (sizeof(float[4]) * meshCapacity));
+  memAlignedFree(indirectPositions, 64);
+  memFree(dirtySlots);
+  staged = NULL;
+  indirectCommands = NULL;
+  indirectPositions = NULL;
+  dirtySlots = NULL;
+  stagedCount = stagedCapacity = drawCapacity = 0;
+
+  // Delete the particle update program
+  glDeleteProgram(particleProgram);
+  particleProgram = 0;
+
+  // Release the HUD (its font goes with the others)
+  if (hud.font) {
+    glDeleteVertexArrays(1, &(hud.vao));
+    glDeleteBuffers(1, &(hud.vbo));
+    trackMemory(MEMORY_TEXT, -(long long) (sizeof(GlyphVertex) * (hud.capacity + hud.text.capacity)));
+    trackMemory(MEMORY_GL_BUFFERS, -(long long) sizeof(GlyphVertex) * hud.capacity);
+    memFree(hud.vertices);
+    memFree(hud.text.vertices);
+    destroyFont(hud.font);
+  }
+  memset(&hud, 0, sizeof(hud));
+
+  // Delete the text program and batch
+  glDeleteProgram(textProgram);
+  glDeleteVertexArrays(1, &textArray);
+  glDeleteBuffers(1, &textBuffer);
+  trackMemory(MEMORY_GL_BUFFERS, -(long long) sizeof(GlyphVertex) * textBufferCapacity);
+  trackMemory(MEMORY_TEXT, -(long long) sizeof(GlyphVertex) * textBatchCapacity);
+  memFree(textBatch);
+  textProgram = textArray = textBuffer = 0;
+  textBatch = NULL;
+  textBatchCapacity = textBufferCapacity = 0;
+
+  // Free the chunk scratch vertices
+  memAlignedFree(bakery, 64);
+  bakery = NULL;
+
+  // Stop the sweeper threads and free the broadphase
+  setBroadphaseThreads(0);
+  trackMemory(MEMORY_ENTITIES, -(long long) sizeof(Proxy) * proxyCapacity);
+  memFree(proxies);
+  proxies = NULL;
+  proxyCount = proxyCapacity = proxiesAdded = 0;
+  for (itr = 0; itr <= SWEEPER_MAX; itr++)
+    memFree(pairLists[itr].pairs);
+  memset(pairLists, 0, sizeof(pairLists));
+
+  // Free the transform order
+  trackMemory(MEMORY_ENTITIES, -(long long) sizeof(Entity*) * transformCapacity);
+  memFree(transforms);
+  transforms = NULL;
+  transformCount = transformCapacity = transformsFrom = 0;
+  transformsSorted = true;
+
+  // Free the frame snapshots
+  for (itr = 0; itr <= RECORDER_MAX; itr++) {
+    memFree(frames[0].lists[itr].commands);
+    memFree(frames[1].lists[itr].commands);
+  }
+  memset(frames, 0, sizeof(frames));
+}
+
+/**
+ * @brief Records draw commands for a slice of the shader queue
+ * 
+ * @param list The draw list to record into
+ * @param begin The first shader index
+ * @param end One past the last shader index
+ */
+static void recordDrawList(DrawList* list, unsigned int begin, unsigned int end) {
+  // Grow the list to fit the slice
+  if (list -> capacity < end - begin) {
+    DrawCommand* commands = (DrawCommand*) memRealloc(list -> commands, sizeof(DrawCommand) * (end - begin));
+    if (!commands)
+      error("Failed to grow draw list!");
+    list -> commands = commands;
+    list -> capacity = end - begin;
+  }
+
+  // Record a command per shader whose entity is alive
+  list -> count = 0;
+  register unsigned int itr;
+  for (itr = begin; itr < end; itr++) {
+    Shader* shader = getElement(shaders, itr);
+    Entity* entity = shader -> entity;
+    if (!entity)
+      continue;
+
+    DrawCommand* command = &(list -> commands[(list -> count)++]);
+    command -> multiDraw = shader -> multiDraw != NULL;
+    command -> program = command -> multiDraw ? shader -> multiDraw -> program : shader -> program;
+    command -> location = shader -> location;
+    command -> vao = shader -> vao;
+    command -> slot = shader -> slot;
+    memcpy(command -> position, entity -> position, sizeof(command -> position));
+
+    // Only upload the position if the program hasn't seen this version of the entity
+    command -> upload = shader -> uploaded != entity -> version;
+    shader -> uploaded = entity -> version;
+  }
+}
+
+/**
+ * @brief Waits for slices to record (recorder thread)
+ * 
+ * @param data The recorder
+ * @return 0 when the recorder stops
+ */
+static int recordDrawLoop(void* data) {
+  Recorder* recorder = (Recorder*) data;
+  while (true) {
+    SDL_SemWait(recorder -> start);
+    if (!SDL_AtomicGet(&recording))
+      break;
+    recordDrawList(recorder -> list, recorder -> begin, recorder -> end);
+    SDL_SemPost(recorder -> done);
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Records the draw commands of every shader, spread over the recorder threads
+ * 
+ * @param frame The frame to record into
+ */
+static void recordDrawLists(Frame* frame) {
+  // Bring the moved hierarchies up to date and drop the released shaders before the recorders read them
+  updateTransforms();
+  if (deadShaders)
+    compactShaders();
+
+  // Only use as many threads as there are full slices of work
+  unsigned int size = queueSize(shaders);
+  unsigned int threads = size / RECORDER_THRESHOLD;
+  if (threads > recorderCount)
+    threads = recorderCount;
+
+  // Hand a contiguous slice to every thread, keeping the first for this one
+  unsigned int slices = threads + 1;
+  register unsigned int itr;
+  for (itr = 0; itr < slices; itr++) {
+    recorders[itr].list = &(frame -> lists[itr]);
+    recorders[itr].begin = (unsigned int) (((unsigned long long) size * itr) / slices);
+    recorders[itr].end = (unsigned int) (((unsigned long long) size * (itr + 1)) / slices);
+  }
+  for (itr = 1; itr < slices; itr++)
+    SDL_SemPost(recorders[itr].start);
+  recordDrawList(recorders[0].list, recorders[0].begin, recorders[0].end);
+  for (itr = 1; itr < slices; itr++)
+    SDL_SemWait(recorders[itr].done);
+
+  frame -> count = slices;
+}
+
+/**
+ * @brief Submits recorded draw lists in order, skipping redundant state changes
+ * 
+ * @param frame The recorded frame
+ */
+static void submitDrawLists(Frame* frame) {
+  GLuint program = 0, vao = 0;
+  unsigned int draws = 0, uploads = 0;
+  register unsigned int list, itr;
+  for (list = 0; list < frame -> count; list++) {
+    DrawList* commands = &(frame -> lists[list]);
+    for (itr = 0; itr < commands -> count; itr++) {
+      DrawCommand* command = &(commands -> commands[itr]);
+
+      // Stage multi-draw commands, to be submitted together
+      if (command -> multiDraw) {
+        if (stagedCount == stagedCapacity) {
+          unsigned int capacity = stagedCapacity ? stagedCapacity << 1 : 1024;
+          StagedDraw* grown = (StagedDraw*) memRealloc(staged, sizeof(StagedDraw) * capacity);
+          if (!grown)
+            error("Failed to grow multi-draw staging!");
+          staged = grown;
+          stagedCapacity = capacity;
+        }
+        staged[stagedCount] = (StagedDraw) { command, stagedCount };
+        stagedCount++;
+        continue;
+      }
+
+      // Use the shader program
+      if (command -> program != program) {
+        program = command -> program;
+        glUseProgram(program);
+      }
+
+      // Set the shader position (programs keep uniforms, so only when it changed)
+      if (command -> upload) {
+        glUniform3fv(command -> location, 1, command -> position);
+        uploads++;
+      }
+
+      // Bind the vertex array object
+      if (command -> vao != vao) {
+        vao = command -> vao;
+        glBindVertexArray(vao);
+      }
+
+      // Draw the triangles
+      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+      draws++;
+    }
+  }
+
+  // Submit the multi-draw commands
+  draws += submitMultiDraws();
+
+  // Update the counters
+  for (list = 0; list < frame -> count; list++)
+    stats.entities += frame -> lists[list].count;
+  stats.drawCalls += draws;
+  stats.uploads += uploads;
+  stats.uploadBytes += (unsigned long long) uploads * sizeof(float[3]);
+}
+
+/**
+ * @brief Orders staged draws by program, keeping the submission order within one
+ * 
+ * @param a The first staged draw
+ * @param b The second staged draw
+ * @return The order of the draws
+ */
+static int compareStagedDraws(const void* a, const void* b) {
+  const StagedDraw* first = (const StagedDraw*) a;
+  const StagedDraw* second = (const StagedDraw*) b;
+  if (first -> command -> program != second -> command -> program)
+    return first -> command -> program < second -> command -> program ? -1 : 1;
+  return first -> order < second -> order ? -1 : first -> order > second -> order;
+}
+
+/**
+ * @brief Orders mesh slots
+ * 
+ * @param a The first slot
+ * @param b The second slot
+ * @return The order of the slots
+ */
+static int compareSlots(const void* a, const void* b) {
+  unsigned int first = *(const unsigned int*) a, second = *(const unsigned int*) b;
+  return first < second ? -1 : first > second;
+}
+
+/**
+ * @brief Submits the staged multi-draw commands, one call per program
+ * 
+ * @return The number of draw calls
+ */
+static unsigned int submitMultiDraws(void) {
+  if (stagedCount == 0)
+    return 0;
+  unsigned int count = stagedCount;
+  stagedCount = 0;
+
+  // Grow the command buffer to fit the frame
+  if (count > drawCapacity) {
+    unsigned int capacity = drawCapacity ? drawCapacity : 1024;
+    while (capacity < count)
+      capacity <<= 1;
+    IndirectCommand* commands = (IndirectCommand*) memRealloc(indirectCommands, sizeof(IndirectCommand) * capacity);
+    if (commands)
+      indirectCommands = commands;
+    unsigned int* slots = (unsigned int*) memRealloc(dirtySlots, sizeof(unsigned int) * capacity);
+    if (slots)
+      dirtySlots = slots;
+    if (!commands || !slots)
+      error("Failed to grow multi-draw buffers!");
+    trackMemory(MEMORY_GL_BUFFERS, (long long) sizeof(IndirectCommand) * (capacity - drawCapacity));
+    drawCapacity = capacity;
+  }
+
+  // Group the draws by program, then write a command per draw (passing its slot as the base instance)
+  // and the position of every slot whose entity moved
+  qsort(staged, count, sizeof(StagedDraw), compareStagedDraws);
+  unsigned int dirty = 0;
+  register unsigned int itr;
+  for (itr = 0; itr < count; itr++) {
+    const DrawCommand* command = staged[itr].command;
+    indirectCommands[itr] = (IndirectCommand) { 6, 1, command -> slot * 6, (GLint) (command -> slot * 4), command -> slot };
+    if (!(command -> upload))
+      continue;
+    memcpy(&indirectPositions[command -> slot * 4], command -> position, sizeof(float[3]));
+    indirectPositions[command -> slot * 4 + 3] = 0.0f;
+    dirtySlots[dirty++] = command -> slot;
+  }
+
+  // Upload the commands into freshly orphaned storage (the previous frame may still be reading it)
+  glNamedBufferData(drawBuffer, sizeof(IndirectCommand) * drawCapacity, NULL, GL_STREAM_DRAW);
+  glNamedBufferSubData(drawBuffer, 0, sizeof(IndirectCommand) * count, indirectCommands);
+
+  // Write the moved slots into the position buffer, a run of neighbouring slots at a time
+  qsort(dirtySlots, dirty, sizeof(unsigned int), compareSlots);
+  unsigned int run = 0;
+  while (run < dirty) {
+    unsigned int end = run + 1;
+    while (end < dirty && dirtySlots[end] == dirtySlots[end - 1] + 1)
+      end++;
+    glNamedBufferSubData(positionBuffer, sizeof(float[4]) * dirtySlots[run], sizeof(float[4]) * (end - run), &indirectPositions[dirtySlots[run] * 4]);
+    run = end;
+  }
+  stats.uploads += count + dirty;
+  stats.uploadBytes += (unsigned long long) count * sizeof(IndirectCommand) + (unsigned long long) dirty * sizeof(float[4]);
+
+  // Draw every program's run of commands with a single call
+  glBindVertexArray(meshArray);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, positionBuffer);
+  unsigned int draws = 0, first = 0;
+  while (first < count) {
+    const DrawCommand* command = staged[first].command;
+    unsigned int last = first + 1;
+    while (last < count && staged[last].command -> program == command -> program)
+      last++;
+
+    glUseProgram(command -> program);
+    glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const void*) (sizeof(IndirectCommand) * first), last - first, 0);
+    draws++;
+    first = last;
+  }
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  glBindVertexArray(0);
+
+  return draws;
+}
+
+/**
+ * @brief Get the counters of the last drawn frame
+ * 
+ * @return The render stats
+ */
+RenderStats getRenderStats(void) {
+  return stats;
+}
+
+/**
+ * @brief Run-length encodes a frame
+ *
+ * Each control byte is followed by either (control + 1) literal pixels when
+ * below 128, or a single pixel repeated (control - 127) times otherwise. The
+ * output is at most count * 4 + count / 128 + 1 bytes.
+ * 
+ * @param pixels The frame's pixels
+ * @param count The number of pixels
+ * @param output The buffer to encode into
+ * @return The number of bytes written
+ */
+static unsigned int compressFrame(const uint32_t* pixels, unsigned int count, unsigned char* output) {
+  unsigned char* out = output;
+  unsigned int itr = 0;
+  while (itr < count) {
+    // Emit a run if the next pixels repeat
+    unsigned int run = 1;
+    while (itr + run < count && run < 128 && pixels[itr + run] == pixels[itr])
+      run++;
+    if (run > 1) {
+      *out++ = (unsigned char) (127 + run);
+      memcpy(out, &pixels[itr], 4);
+      out += 4;
+      itr += run;
+      continue;
+    }
+
+    // Otherwise gather literals up to the start of the next run
+    unsigned int literal = 1;
+    while (itr + literal < count && literal < 128 && !(itr + literal + 1 < count && pixels[itr + literal] == pixels[itr + literal + 1]))
+      literal++;
+    *out++ = (unsigned char) (literal - 1);
+    memcpy(out, &pixels[itr], literal * 4);
+    out += literal * 4;
+    itr += literal;
+  }
+
+  return (unsigned int) (out - output);
+}
+
+/**
+ * @brief Writes a frame to its stream, or closes the stream (encoder thread)
+ * 
+ * @param job The stream job
+ */
+static void writeStreamFrame(CaptureJob* job) {
+  Stream* output = job -> stream;
+
+  // A job without pixels closes the stream
+  if (!(job -> image)) {
+    if (output -> file)
+      fclose(output -> file);
+    memFree(output -> scratch);
+    memFree(output -> path);
+    memFree(output);
+    return;
+  }
+
+  // Drop the frames of a stream that has failed (reporting it once)
+  BMP* image = job -> image;
+  unsigned int size = image -> header.imagesize;
+  if (SDL_AtomicGet(&(output -> failed))) {
+    SDL_AtomicAdd(&streamDropped, 1);
+    SDL_AtomicAdd(&streamPending, -1);
+    return;
+  }
+  if (!(output -> file)) {
+    // Open the file here, since opening a named pipe blocks until a reader attaches
+    output -> file = fopen(output -> path, "wb");
+    if (!(output -> file)) {
+      fprintf(stderr, "Error: Could not open \"%s\".\n", output -> path);
+      SDL_AtomicSet(&(output -> failed), 1);
+      SDL_AtomicAdd(&streamDropped, 1);
+      SDL_AtomicAdd(&streamPending, -1);
+      return;
+    }
+    fwrite("NANITEFS", 8, 1, output -> file);
+
+    // Reserve the whole recording up front so frames never extend the file
+    #ifdef __linux__
+      struct stat info;
+      if (output -> limit && fstat(fileno(output -> file), &info) == 0 && S_ISREG(info.st_mode))
+        posix_fallocate(fileno(output -> file), 0, 8 + (off_t) (output -> limit) * (16 + size));
+    #endif
+  }
+
+  // Compress the frame, if requested
+  const unsigned char* data = image -> data;
+  if (output -> compress) {
+    unsigned int bound = size + size / 512 + 1;
+    if (output -> scratchSize < bound) {
+      memFree(output -> scratch);
+      output -> scratch = (unsigned char*) memAlloc(bound);
+      if (!(output -> scratch))
+        error("Failed to allocate stream buffer!");
+      output -> scratchSize = bound;
+    }
+    size = compressFrame((const uint32_t*) image -> data, size / 4, output -> scratch);
+    data = output -> scratch;
+  }
+
+  // Write the frame header and pixels
+  unsigned char header[16], *itr = header;
+  itr = packBMP(itr, job -> index, 4);
+  itr = packBMP(itr, image -> header.width, 4);
+  itr = packBMP(itr, image -> header.height, 4);
+  itr = packBMP(itr, size, 4);
+  if (fwrite(header, sizeof(header), 1, output -> file) != 1 || fwrite(data, size, 1, output -> file) != 1) {
+    fprintf(stderr, "Error: Could not write to \"%s\".\n", output -> path);
+    SDL_AtomicSet(&(output -> failed), 1);
+    SDL_AtomicAdd(&streamDropped, 1);
+  }
+
+  SDL_AtomicAdd(&streamPending, -1);
+}
+
+/**
+ * @brief Writes captured frames to disk (encoder thread)
+ * 
+ * @param data Unused
+ * @return 0 when the encoder stops
+ */
+static int encodeCaptures(void* data) {
+  (void) data;
+  while (true) {
+    SDL_SemWait(encoderWake);
+
+    // Encode everything that's been handed over
+    CaptureJob* job;
+    while ((job = spscDequeue(captureJobs))) {
+      if (job -> filename) {
+        saveBMP(job -> filename, job -> image);
+        memFree(job -> filename);
+      } else
+        writeStreamFrame(job);
+      if (job -> image)
+        freeBMP(job -> image);
+      memFree(job);
+    }
+
+    if (!SDL_AtomicGet(&encoding))
+      break;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief Starts the encoder thread, the first time a frame is captured
+ */
+static void startEncoder(void) {
+  // Verify that the encoder isn't already running
+  if (encoderThread)
+    return;
+
+  captureRequests = createQueue();
+  captureJobs = createSPSCQueue(64);
+  encoderWake = SDL_CreateSemaphore(0);
+  SDL_AtomicSet(&encoding, 1);
+  encoderThread = SDL_CreateThread(encodeCaptures, "nanite-encoder", NULL);
+  if (!encoderThread)
+    error("Failed to create encoder thread!");
+}
+
+/**
+ * @brief Queues a capture request (render call)
+ * 
+ * @param data The BMP filename
+ */
+static void captureCall(void* data) {
+  startEncoder();
+  enqueue(captureRequests, memStrdup((const char*) data));
+}
+
+/**
+ * @brief Hands a job to the encoder thread
+ * 
+ * @param job The job
+ * @return true if the encoder accepted the job
+ */
+static bool submitCaptureJob(CaptureJob* job) {
+  if (!spscEnqueue(captureJobs, job))
+    return false;
+
+  SDL_SemPost(encoderWake);
+  return true;
+}
+
+/**
+ * @brief Closes the current stream behind its pending frames (render call)
+ * 
+ * @param data Unused
+ */
+static void stopRecordingCall(void* data) {
+  (void) data;
+
+  // Verify that a stream is being recorded
+  if (!stream)
+    return;
+
+  // Flush the frames still in flight
+  readCaptures(true);
+
+  // Queue the close behind them
+  CaptureJob* job = (CaptureJob*) memCalloc(1, sizeof(CaptureJob));
+  job -> stream = stream;
+  while (!submitCaptureJob(job))
+    SDL_Delay(1);
+
+  unsigned int dropped = (unsigned int) SDL_AtomicGet(&streamDropped);
+  printf("\x1b[5m\x1B[32mRecorded\x1B[0m: \"%s\" (%u frames, %u dropped)\n", stream -> path, streamFrames - dropped, dropped);
+  stream = NULL;
+}
+
+/**
+ * @brief Starts a stream (render call)
+ * 
+ * @param data The stream
+ */
+static void startRecordingCall(void* data) {
+  stopRecordingCall(NULL);
+  startEncoder();
+
+  stream = (Stream*) data;
+  streamFrames = 0;
+  SDL_AtomicSet(&streamDropped, 0);
+}
+
+/**
+ * @brief Starts streaming every rendered frame to a file or named pipe
+ * 
+ * @param path The file or named pipe
+ * @param frames The number of frames to record (0 for no limit), preallocated for files
+ * @param compress Whether to run-length encode frames on the encoder thread
+ */
+void startRecording(const char* path, unsigned int frames, bool compress) {
+  // Verify that the path exists
+  if (!path)
+    return;
+
+  Stream* output = (Stream*) memCalloc(1, sizeof(Stream));
+  output -> path = memStrdup(path);
+  output -> limit = frames;
+  output -> compress = compress;
+  renderCall(startRecordingCall, output);
+}
+
+/**
+ * @brief Stops streaming frames, flushing those still in flight
+ */
+void stopRecording(void) {
+  renderCall(stopRecordingCall, NULL);
+}
+
+/**
+ * @brief Get the number of frames dropped by the current or last recording
+ * 
+ * @return The number of dropped frames
+ */
+unsigned int droppedFrames(void) {
+  return (unsigned int) SDL_AtomicGet(&streamDropped);
+}
 
 /**
- * @brief Creates a new entity and enqueues it
+ * @brief Captures the next rendered frame into a BMP file without stalling the pipeline
  * 
- * @param ID A string containing the entity's id
- * @param dimensions The width and height of the entity
- * @param position The position of the entity on the screen
+ * @param filename The BMP filename
  */
-void createEntity(char* ID, int dimensions[2], float position[3]) {
-  // Verify that the id and position exist
-  if (!ID || !dimensions || !position)
+void captureFrame(const char* filename) {
+  // Verify that the filename exists
+  if (!filename)
     return;
 
-  // Creates an Entity pointer
-  Entity* entity = (Entity*) malloc(sizeof(Entity));
-
-  // Sets entity ID
-  entity -> ID = ID;
+  // The request is picked up by the thread owning the context
+  renderCall(captureCall, (void*) filename);
+}
 
-  // Set entity dimensions
-  entity -> width = dimensions[0];
-  entity -> height = dimensions[1];
+/**
+ * @brief Starts an asynchronous read of the backbuffer into the next pixel buffer object
+ * 
+ * @param window The window being rendered to
+ * @param format The pixel format (GL_BGRA for BMP files, GL_RGBA for streams)
+ * @return The capture being read into, NULL if the next buffer is still busy
+ */
+static Capture* readBackbuffer(SDL_Window* window, GLenum format) {
+  // Verify that the next buffer is free
+  Capture* capture = &captures[captureNext];
+  if (capture -> filename || capture -> stream)
+    return NULL;
 
-  // Set entity position
-  entity -> position[0] = position[0];
-  entity -> position[1] = position[1];
-  entity -> position[2] = position[2];
+  // Size the buffer to the drawable
+  SDL_GL_GetDrawableSize(window, &(capture -> width), &(capture -> height));
+  unsigned int size = (unsigned int) (capture -> width) * (capture -> height) * 4;
+  if (capture -> pbo == 0)
+    glGenBuffers(1, &(capture -> pbo));
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, capture -> pbo);
+  if (capture -> size != size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER, size, NULL, GL_STREAM_READ);
+    trackMemory(MEMORY_GL_BUFFERS, (long long) size - capture -> size);
+    capture -> size = size;
+  }
 
-  // Set entity verticies
-  entity -> vertices[0]  =  (entity -> width) * (1.0f / 20.0f) / 2;     // Top right vertex x-pos
-  entity -> vertices[1]  =  (entity -> height) * (1.0f / 15.0f) / 2;    // Top right vertex y-pos
-  entity -> vertices[3]  =  (entity -> width) * (1.0f / 20.0f) / 2;     // Bottom right vertex x-pos
-  entity -> vertices[4]  = -(entity -> height) * (1.0f / 15.0f) / 2;    // Bottom right vertex y-pos
-  entity -> vertices[6]  = -(entity -> width) * (1.0f / 20.0f) / 2;     // Bottom left vertex x-pos
-  entity -> vertices[7]  = -(entity -> height) * (1.0f / 15.0f) / 2;    // Bottom left vertex y-pos
-  entity -> vertices[9]  = -(entity -> width) * (1.0f / 20.0f) / 2;     // Top left vertex x-pos
-  entity -> vertices[10] =  (entity -> height) * (1.0f / 15.0f) / 2;    // Top left vertex y-pos
+  // Start the read; rows come out bottom-up, which is also BMP's layout
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glReadPixels(0, 0, capture -> width, capture -> height, format, GL_UNSIGNED_BYTE, 0);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  capture -> fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  captureNext = (captureNext + 1) % CAPTURE_BUFFERS;
+  return capture;
+}
 
-  // Set entity indices
-  entity -> indices[0] = 0;
-  entity -> indices[1] = 1;
-  entity -> indices[2] = 3;
-  entity -> indices[3] = 1;
-  entity -> indices[4] = 2;
-  entity -> indices[5] = 3;
+/**
+ * @brief Reads the backbuffer into a free pixel buffer object, if a capture is requested
+ * 
+ * @param window The window being rendered to
+ */
+static void requestCaptures(SDL_Window* window) {
+  // Read a frame for the next BMP request
+  if (!isEmpty(captureRequests)) {
+    Capture* capture = readBackbuffer(window, GL_BGRA);
+    if (capture)
+      capture -> filename = dequeue(captureRequests);
+  }
 
-  // Appends the entity into the entity map
-  insert(entities, ID, entity);
+  // Read every frame for the stream, dropping it if the encoder is too far behind (or the stream failed)
+  if (stream && (!(stream -> limit) || streamFrames < stream -> limit)) {
+    Capture* capture = NULL;
+    if (!SDL_AtomicGet(&(stream -> failed)) && SDL_AtomicGet(&streamPending) < STREAM_BUFFERS)
+      capture = readBackbuffer(window, GL_RGBA);
+    if (capture) {
+      capture -> stream = stream;
+      capture -> index = streamFrames;
+      SDL_AtomicAdd(&streamPending, 1);
+    } else
+      SDL_AtomicAdd(&streamDropped, 1);
+    streamFrames++;
+  }
 }
 
 /**
- * @brief Get the pointer of an entity from it's ID
+ * @brief Hands every capture whose fence has signaled to the encoder thread
  * 
- * @param ID An entity ID
- * @return A pointer to the entity
+ * @param wait Whether to block until every capture has signaled
  */
-Entity* getEntity(char* ID) {
-  // Verifies the id exists
-  if (!ID)
-    return NULL;
-
-  // Search the hash map and return the result
-  return search(entities, ID);
+static void readCaptures(bool wait) {
+  register unsigned int itr;
+  for (itr = 0; itr < CAPTURE_BUFFERS; itr++) {
+    Capture* capture = &captures[itr];
+    if (!(capture -> fence))
+      continue;
+
+    // Check (or wait for) the fence
+    GLenum status = wait
+      ? glClientWaitSync(capture -> fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED)
+      : glClientWaitSync(capture -> fence, 0, 0);
+    if (status == GL_TIMEOUT_EXPIRED)
+      continue;
+    glDeleteSync(capture -> fence);
+    capture -> fence = 0;
+
+    // Copy the pixels out of the buffer
+    BMP* image = (BMP*) memAlloc(sizeof(BMP));
+    image -> data = (unsigned char*) memAlloc(capture -> size);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture -> pbo);
+    void* pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, capture -> size, GL_MAP_READ_BIT);
+    if (pixels)
+      memcpy(image -> data, pixels, capture -> size);
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // Fill in a 32-bit uncompressed header
+    image -> header = (HEADER) {
+      .signature = 0x4D42,
+      .filesize = 54 + capture -> size,
+      .dataoffset = 54,
+      .headersize = 40,
+      .width = capture -> width,
+      .height = capture -> height,
+      .planes = 1,
+      .bitsperpixel = 32,
+      .imagesize = capture -> size,
+      .xresolution = 2835,
+      .yresolution = 2835,
+    };
+    trackMemory(MEMORY_ASSETS, sizeof(BMP) + capture -> size);
+
+    // Hand the frame to the encoder thread (dropping it if the encoder is that far behind)
+    CaptureJob* job = (CaptureJob*) memAlloc(sizeof(CaptureJob));
+    job -> filename = capture -> filename;
+    job -> image = image;
+    job -> stream = capture -> stream;
+    job -> index = capture -> index;
+    capture -> filename = NULL;
+    capture -> stream = NULL;
+    if (!pixels || !submitCaptureJob(job)) {
+      if (job -> filename)
+        fprintf(stderr, "Error: Could not capture \"%s\".\n", job -> filename);
+      else {
+        SDL_AtomicAdd(&streamPending, -1);
+        SDL_AtomicAdd(&streamDropped, 1);
+      }
+      freeBMP(image);
+      memFree(job -> filename);
+      memFree(job);
+    }
+  }
 }
 
 /**
- * @brief Get entity position
+ * @brief Draws a recorded frame and swaps the buffers
  * 
- * @param ID The entity ID
- * @return An array containing the entity's coordinates
+ * @param window The window to render to
+ * @param frame The recorded frame
  */
-float* getEntityPosition(char* ID) {
-  // Verifies the id exists
-  if (!ID)
-    return NULL;
+static void drawFrame(SDL_Window* window, Frame* frame) {
+  // Delete any garbage the GPU has finished with.
+  register unsigned int itr;
+  for (itr = 0; itr < GARBAGE_FRAMES; itr++)
+    reclaimGarbage(&garbage[itr], false);
+
+  // Hand finished captures to the encoder.
+  if (encoderThread)
+    readCaptures(false);
+
+  // Don't time a lazy loop's idle wait as a frame.
+  if (SDL_AtomicSet(&frameResumed, 0)) {
+    hud.last = 0;
+    skipFrameMetrics();
+  }
 
-  // Get the entity from the hash map, if it exists
-  Entity* entity = getEntity(ID);
-  if (!entity)
-    return NULL;
+  // Clear the screen (or the scaled render target).
+  beginScene(window);
+  glClearDepth(1.00f);
+  glClearColor(0.08f, 0.10f, 0.10f, 1.00f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-  // Return the entity's position
-  return (float[3]) {entity -> position[0], entity -> position[1], entity -> position[2]};
+  // Draw the tilemaps behind the entities, then the entities, the particles and the text.
+  stats = (RenderStats) { 0 };
+  stats.drawCalls = drawTilemaps();
+  submitDrawLists(frame);
+  stats.drawCalls += drawEmitters();
+  stats.drawCalls += drawTexts();
+  if (glGetError() != GL_NO_ERROR)
+    error("Failed to draw elements!");
+
+  // Upscale the render target to the backbuffer, then draw the HUD over it at full resolution.
+  endScene();
+  drawHUD();
+
+  // Read the backbuffer for any requested capture.
+  if (encoderThread)
+    requestCaptures(window);
+
+  // Swap the buffers.
+  SDL_GL_SwapWindow(window);
+
+  // Fence this frame's garbage, then count the frame.
+  fenceGarbage();
+  recordFrameMetrics(stats.drawCalls, stats.uploads, stats.uploadBytes, stats.entities);
 }
 
 /**
- * @brief Update entity position
+ * @brief Render the scene.
  * 
- * @param ID The entity ID
- * @param delta The changed in position
+ * @param window The window to render to.
  */
-void updateEntityPosition(char* ID, float delta[3]) {
-  // Verify that the id and delta exist
-  if (!ID || !delta)
-    return;
+void render(SDL_Window* window) {
+  // Verify that the window isn't null.
+  if (!window)
+    error("Window pointer is null!");
 
-  // Get the entity from the hash map, if it exists
-  Entity* entity = getEntity(ID);
-  if (!entity)
-    return;
+  // Swap in any shader programs whose files changed.
+  reloadShaders();
 
-  // Update the entity's position
-  entity -> position[0] += delta[0];
-  entity -> position[1] += delta[1];
-  entity -> position[2] += delta[2];
+  // Record the draw lists (in parallel for large scenes), then draw them here.
+  recordDrawLists(&frames[0]);
+  drawFrame(window, &frames[0]);
 }
 
 /**
- * @brief Creates a new shader and enqueues it
+ * @brief Runs a function on the thread owning the OpenGL context, waiting for it
  * 
- * @param entityID Entity id
- * @param vertFile Vertex shader filename
- * @param fragFile Fragment shader filename
+ * @param task The function to run
+ * @param data The function's argument
  */
-void createShader(char* entityID, const char* vertFile, const char* fragFile) {
-  // Verify that the entity and filenames exist
-  if (!entityID || !vertFile || !fragFile)
+static void renderCall(void (*task)(void*), void* data) {
+  // Run the function directly if this thread owns the context
+  if (!renderThread || SDL_ThreadID() == renderThreadID) {
+    task(data);
     return;
+  }
 
-  // Create the shader
-  Shader* shader = (Shader*) malloc(sizeof(Shader));
-  shader -> entityID = entityID;
-
-  // Generate the vertex array
-  glGenVertexArrays(1, &(shader -> vao));
-  if (shader -> vao == 0)
-    error("Failed to create vertex array object!");
-
-    // Create the vertex array object.
-  glGenVertexArrays(1, &(shader -> vao));
-  if (shader -> vao == 0)
-    error("Failed to create vertex array object!");
-
-  // Create the vertex buffer object.
-  glGenBuffers(1, &(shader -> vbo));
-  if (shader -> vbo == 0)
-    error("Failed to create vertex buffer object!");
-
-  // Create the element buffer object.
-  glGenBuffers(1, &(shader -> ebo));
-  if (shader -> ebo == 0)
-    error("Failed to create element buffer object!");
+  // Otherwise wake the render thread and wait for it to run the function
+  renderTaskData = data;
+  SDL_AtomicSetPtr((void**) &renderTask, (void*) task);
+  SDL_SemPost(renderWake);
+  SDL_SemWait(renderTaskDone);
+}
 
-  // Bind the vertex array object.
-  glBindVertexArray(shader -> vao);
+/**
+ * @brief Draws frame snapshots and runs calls until stopped (render thread)
+ * 
+ * @param data Unused
+ * @return 0 when the render thread stops
+ */
+static int renderLoop(void* data) {
+  (void) data;
+  SDL_GL_MakeCurrent(renderWindow, renderContext);
+
+  while (true) {
+    SDL_SemWait(renderWake);
+
+    // Run a call from the simulation thread (which is waiting on it)
+    void (*task)(void*) = (void (*)(void*)) SDL_AtomicGetPtr((void**) &renderTask);
+    if (task) {
+      task(renderTaskData);
+      SDL_AtomicSetPtr((void**) &renderTask, NULL);
+      SDL_SemPost(renderTaskDone);
+      continue;
+    }
 
-  // Bind the vertex buffer object.
-  glBindBuffer(GL_ARRAY_BUFFER, shader -> vbo);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(getEntity(entityID) -> vertices), getEntity(entityID) -> vertices, GL_DYNAMIC_DRAW);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to bind vertex buffer object!");
+    // A wake without a snapshot is a stop request
+    if (SDL_AtomicGet(&framesReady) == 0)
+      break;
 
-  // Bind the element buffer object.
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, shader -> ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(getEntity(entityID) -> indices), getEntity(entityID) -> indices, GL_DYNAMIC_DRAW);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to bind element buffer object!");
+    // Draw the oldest snapshot and give it back to the simulation thread
+    drawFrame(renderWindow, &frames[frameRead]);
+    frameRead ^= 1;
+    SDL_AtomicAdd(&framesReady, -1);
+    SDL_SemPost(framesFree);
+  }
 
-  // Set the vertex attribute pointers.
-  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-  glEnableVertexAttribArray(0);
+  SDL_GL_MakeCurrent(renderWindow, NULL);
+  return 0;
+}
 
-  // Create the vertex shader.
-  GLuint vertShader = glCreateShader(GL_VERTEX_SHADER);
-  if (vertShader == 0)
-    error("Failed to create vertex shader!");
+/**
+ * @brief Moves the OpenGL context to a dedicated render thread
+ * 
+ * @param window The window to render to
+ * @param context The OpenGL context (current on the calling thread)
+ */
+void startRenderThread(SDL_Window* window, SDL_GLContext context) {
+  // Verify that the render thread isn't already running
+  if (renderThread)
+    return;
 
-  // Load the vertex shader.
-  char* vertSource = readfile(vertFile);
-  if (vertSource == NULL)
-    error("Failed to read vertex shader file!");
+  // Release the context so the render thread can take it
+  SDL_GL_MakeCurrent(window, NULL);
+  renderWindow = window;
+  renderContext = context;
+
+  // Initialize the handoff, with both snapshots free
+  framesFree = SDL_CreateSemaphore(2);
+  renderWake = SDL_CreateSemaphore(0);
+  renderTaskDone = SDL_CreateSemaphore(0);
+  SDL_AtomicSet(&framesReady, 0);
+  frameWrite = frameRead = 0;
+
+  // Start the render thread
+  renderThread = SDL_CreateThread(renderLoop, "nanite-render", NULL);
+  if (!renderThread)
+    error("Failed to create render thread!");
+  renderThreadID = SDL_GetThreadID(renderThread);
+}
 
-  // Compile the vertex shader.
-  glShaderSource(vertShader, 1, (const char**) &vertSource, NULL);
-  glCompileShader(vertShader);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to compile vertex shader!");
+/**
+ * @brief Stops the render thread, making the OpenGL context current on the calling thread
+ */
+void stopRenderThread(void) {
+  // Verify that the render thread is running
+  if (!renderThread)
+    return;
 
-  // Create the fragment shader.
-  GLuint fragShader = glCreateShader(GL_FRAGMENT_SHADER);
-  if (fragShader == 0)
-    error("Failed to create fragment shader!");
+  // Let the render thread draw what's pending, then stop it
+  SDL_SemPost(renderWake);
+  SDL_WaitThread(renderThread, NULL);
+  renderThread = NULL;
+  renderThreadID = 0;
 
-  // Load the fragment shader.
-  char* fragSource = readfile(fragFile);
-  if (fragSource == NULL)
-    error("Failed to read fragment shader file!");
+  // Free the handoff
+  SDL_DestroySemaphore(framesFree);
+  SDL_DestroySemaphore(renderWake);
+  SDL_DestroySemaphore(renderTaskDone);
+  framesFree = renderWake = renderTaskDone = NULL;
 
-  // Compile the fragment shader.
-  glShaderSource(fragShader, 1, (const char**) &fragSource, NULL);
-  glCompileShader(fragShader);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to compile fragment shader!");
+  // Take the context back
+  SDL_GL_MakeCurrent(renderWindow, renderContext);
+}
 
-  // Create the shader program.
-  shader -> program = glCreateProgram();
-  if (shader -> program == 0)
-    error("Failed to create shader program!");
+/**
+ * @brief Swaps in changed shader programs (render call)
+ * 
+ * @param data Unused
+ */
+static void reloadCall(void* data) {
+  (void) data;
+  reloadShaders();
+}
 
-  // Attach the vertex shader.
-  glAttachShader(shader -> program, vertShader);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to attach vertex shader!");
+/**
+ * @brief Sets the swap interval (render call)
+ * 
+ * @param data The swap interval
+ */
+static void swapIntervalCall(void* data) {
+  SDL_GL_SetSwapInterval(*(int*) data);
+}
 
-  // Attach the fragment shader.
-  glAttachShader(shader -> program, fragShader);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to attach fragment shader!");
+/**
+ * @brief Records a frame snapshot and hands it to the render thread
+ */
+void publishFrame(void) {
+  // Fall back to rendering here without a render thread
+  if (!renderThread) {
+    render(renderWindow);
+    return;
+  }
 
-  // Link the shader program.
-  glLinkProgram(shader -> program);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to link shader program!");
+  // Swap in changed shader programs while the snapshot isn't being recorded
+  if (reloadsPending())
+    renderCall(reloadCall, NULL);
 
-  // Delete the vertex shader.
-  glDeleteShader(vertShader);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to delete vertex shader!");
+  // Wait for a free snapshot (the render thread is at most one frame behind)
+  SDL_SemWait(framesFree);
 
-  // Delete the fragment shader.
-  glDeleteShader(fragShader);
-  if (glGetError() != GL_NO_ERROR)
-    error("Failed to delete fragment shader!");
+  // Record the snapshot and publish it
+  recordDrawLists(&frames[frameWrite]);
+  frameWrite ^= 1;
+  SDL_AtomicAdd(&framesReady, 1);
+  SDL_SemPost(renderWake);
+}
 
-  // Add shader to queue
-  enqueue(shaders, shader);
+/**
+ * @brief Asks a lazy loop for another frame (called by anything that changes what's drawn)
+ */
+void requestFrame(void) {
+  // Wake a sleeping loop once per frame, whichever thread asks
+  if (SDL_AtomicCAS(&redrawRequested, 0, 1) && wakeEvent) {
+    SDL_Event event = { .type = wakeEvent };
+    SDL_PushEvent(&event);
+  }
 }
 
 /**
- * @brief Initialize OpenGL
+ * @brief Asks a lazy loop for a frame after a delay (for timers and animations)
+ * 
+ * @param delay The time until the frame (ms)
  */
-void initialize(void) {
-  // Initialize GLEW.
-  glewExperimental = GL_TRUE;
-  GLenum glewError = glewInit();
-  if (glewError != GLEW_OK)
-    error(strcat("GLEW Failed to Initialize!\n> ", glewGetErrorString(glewInit())));
+void requestFrameAfter(unsigned int delay) {
+  if (delay == 0) {
+    requestFrame();
+    return;
+  }
 
-  // Initialize render field variables
-  shaders = createQueue();
-  entities = createHashMap();
+  // Keep the earliest deadline (0 means none, so skip it)
+  Uint32 deadline = SDL_GetTicks() + delay;
+  deadline += deadline == 0;
+  int current;
+  do {
+    current = SDL_AtomicGet(&redrawDeadline);
+    if (current && (Sint32) ((Uint32) current - deadline) <= 0)
+      return;
+  } while (!SDL_AtomicCAS(&redrawDeadline, current, (int) deadline));
 }
 
 /**
- * @brief Render the scene.
+ * @brief Gets how long a lazy loop can sleep before a frame is due
  * 
- * @param window The window to render to.
+ * @return The time until the next frame (ms), 0 if one is due, -1 if nothing has asked for one
  */
-void render(SDL_Window* window) {
-  // Verify that the window isn't null.
-  if (!window)
-    error("Window pointer is null!");
+int pendingFrame(void) {
+  if (SDL_AtomicGet(&redrawRequested) || reloadsPending())
+    return 0;
+
+  // Sleep until the earliest timer, or indefinitely without one
+  Uint32 deadline = (Uint32) SDL_AtomicGet(&redrawDeadline);
+  if (!deadline)
+    return -1;
+  Sint32 remaining = (Sint32) (deadline - SDL_GetTicks());
+  return remaining > 0 ? remaining : 0;
+}
 
-  // Clear the screen.
-  glClearDepth(1.00f);
-  glClearColor(0.08f, 0.10f, 0.10f, 1.00f);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+/**
+ * @brief Sleeps until there's input to handle or a frame is due (lazy loops)
+ * 
+ * @return true if the loop should step and draw, false if it should keep waiting
+ */
+bool awaitFrame(void) {
+  // Register the wake event before the first sleep
+  if (!wakeEvent) {
+    wakeEvent = SDL_RegisterEvents(1);
+    if (wakeEvent == (Uint32) -1)
+      wakeEvent = 0;
+  }
 
-  // Render the shaders.
-  if (!isEmpty(shaders)) {  // Verify that the shader queue isn't empty
-    register int itr;
-    for (itr = 0; itr < queueSize(shaders); itr++) {
-      // Dequeue the shader
-      Shader* shader = dequeue(shaders);
+  // Sleep on the event queue (a woken loop polls the event itself)
+  int timeout = pendingFrame();
+  if (timeout == 0)
+    return true;
+  bool woken = timeout < 0 ? SDL_WaitEvent(NULL) : SDL_WaitEventTimeout(NULL, timeout);
 
-      // Use the shader program
-      glUseProgram(shader -> program);
-      if (glGetError() != GL_NO_ERROR)
-        error("Failed to use shader program!");
-
-      // Set the shader position.
-      glUniform3fv(glGetUniformLocation(shader -> program, "position"), 1, getEntityPosition(shader -> entityID));
-      if (glGetError() != GL_NO_ERROR)
-        error("Failed to set shader position!");
-
-      // Bind the vertex array object.
-      glBindVertexArray(shader -> vao);
-      if (glGetError() != GL_NO_ERROR)
-        error("Failed to bind vertex array object!");
-      
-      // Draw the triangles.
-      glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-      if (glGetError() != GL_NO_ERROR)
-        error("Failed to draw elements!");
+  // Tell the next frame it follows an idle wait, so the wait isn't timed as a frame
+  SDL_AtomicSet(&frameResumed, 1);
+  return woken || pendingFrame() == 0;
+}
 
-      // Enqueue the shader
-      enqueue(shaders, shader);
-    }
-  }
+/**
+ * @brief Clears the frame requests the frame about to be drawn satisfies
+ */
+static void takeFrameRequests(void) {
+  SDL_AtomicSet(&redrawRequested, 0);
 
-  // Swap the buffers.
-  SDL_GL_SwapWindow(window);
+  // Clear a timer that's come due (a later one keeps waiting)
+  Uint32 deadline = (Uint32) SDL_AtomicGet(&redrawDeadline);
+  if (deadline && (Sint32) (deadline - SDL_GetTicks()) <= 0)
+    SDL_AtomicCAS(&redrawDeadline, (int) deadline, 0);
 }
 
 #endif // NANITE_RENDER_IMPLEMENTATION
@@ -981,6 +8545,15 @@ typedef struct Application {
 
   bool running;           // Whether the application is running.
   bool fullscreen, vsync; // Whether the window is fullscreen and vsync is enabled.
+  bool threaded;          // Whether rendering runs on its own thread.
+  bool headless;          // Whether to render offscreen, without a visible window.
+  bool dynamicResolution; // Whether to scale the render resolution to hold the fps.
+  bool resizable;         // Whether the user can resize the window.
+  bool hud;               // Whether F3 toggles the performance HUD.
+  bool lazy;              // Whether to sleep until input, a change or a timer needs a frame.
+
+  const char* metrics;    // Where to export metrics (a file, or "unix:" and a socket path), NULL to disable.
+  bool metricsJSON;       // Whether metrics are exported as JSON lines, instead of Prometheus text.
   
   void (*load)(void);     // The function to call when the application is loaded.
   void (*step)(void);     // The function to call when the application is stepped.
@@ -1147,6 +8720,10 @@ void run(Application* app) {
 
   printf("\x1b[5m\x1B[32mInitializing\x1B[0m: \"%s\"\n", app -> title);
 
+  // Use the offscreen video driver when headless (unless one is forced).
+  if (app -> headless)
+    SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+
   // Initialize SDL.
   if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_NOPARACHUTE) != 0)
     error(strcat("SDL2 Failed to Initialize!\n> ", SDL_GetError()));
@@ -1166,15 +8743,23 @@ void run(Application* app) {
     app -> title,
     app -> x, app -> y,
     app -> width, app -> height,
-    SDL_WINDOW_OPENGL | (app -> fullscreen ? SDL_WINDOW_FULLSCREEN : 0)
+    SDL_WINDOW_OPENGL | (app -> fullscreen ? SDL_WINDOW_FULLSCREEN : 0) | (app -> headless ? SDL_WINDOW_HIDDEN : 0) | (app -> resizable ? SDL_WINDOW_RESIZABLE : 0)
   );
 
   // Check if the window failed to initialize.
   if (!app -> window)
     error(strcat("SDL2 Failed to Create Window!\n> ", SDL_GetError()));
 
-  // Initialize the OpenGL context.
-  app -> context = SDL_GL_CreateContext(app -> window);
+  // Initialize the OpenGL context (4.5 for the multi-draw backend, falling back to 3.3).
+  #if !defined(NO_NANITE_RENDER) && !defined(NO_NANITE_MULTIDRAW)
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 5);
+    app -> context = SDL_GL_CreateContext(app -> window);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+  #endif
+  if (!app -> context)
+    app -> context = SDL_GL_CreateContext(app -> window);
   if (!app -> context)
     error(strcat("SDL2 Failed to Create OpenGL Context!\n> ", SDL_GetError()));
 
@@ -1189,10 +8774,26 @@ void run(Application* app) {
   else
     SDL_GL_SetSwapInterval(0);
 
+  // Scale the render resolution to hold the fps.
+  #ifndef NO_NANITE_RENDER
+    if (app -> dynamicResolution)
+      setDynamicResolution(true, app -> fps);
+  #endif
+
+  // Start exporting metrics (before loading, so asset load times are counted).
+  if (app -> metrics && !startMetrics(app -> metrics, app -> metricsJSON ? METRICS_JSON : METRICS_PROMETHEUS, METRICS_INTERVAL))
+    fprintf(stderr, "Error: Could not export metrics to \"%s\".\n", app -> metrics);
+
   // Call the load function.
   if (app -> load)
     app -> load();
 
+  // Move the OpenGL context to the render thread.
+  #ifndef NO_NANITE_RENDER
+    if (app -> threaded)
+      startRenderThread(app -> window, app -> context);
+  #endif
+
   printf("\x1b[1A\x1b[0K\x1b[5m\x1B[32mInitialized\x1B[0m: \"%s\"\n", app -> title);
 
   printf("\x1b[5m\x1B[32mRunning\x1B[0m: \"%s\"\n", app -> title);
@@ -1208,12 +8809,40 @@ void run(Application* app) {
 
     // Wait for the next frame.
     if (delta > (1000.0 / app -> fps)) {
+      // Sleep until there's input or something to draw (held keys keep stepping).
+      #ifndef NO_NANITE_RENDER
+        #ifndef NO_NANITE_INPUT
+          bool held = inputHeld();
+        #else
+          bool held = false;
+        #endif
+        if (app -> lazy && !held && pendingFrame() != 0) {
+          if (!awaitFrame())
+            continue;
+
+          // Step a single frame after idling (the wait isn't simulation time).
+          now = time();
+          delta = 1000.0 / app -> fps;
+        }
+      #endif
+
       // Poll for events.
       SDL_Event event;
-      if (SDL_PollEvent(&event)) {
+      while (SDL_PollEvent(&event)) {
         // Check for quit.
         if (event.type == SDL_QUIT)
           app -> running = false;
+
+        // Track the keyboard.
+        #ifndef NO_NANITE_INPUT
+          handleInputEvent(&event);
+        #endif
+
+        // Track the window size (the renderer follows the drawable on its own).
+        if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+          app -> width = event.window.data1;
+          app -> height = event.window.data2;
+        }
       }
 
       // Process input.
@@ -1221,13 +8850,23 @@ void run(Application* app) {
         processInput();
       #endif
 
+      // Toggle the performance HUD.
+      #if !defined(NO_NANITE_INPUT) && !defined(NO_NANITE_RENDER)
+        if (app -> hud && keyPressed(KEY_F3))
+          toggleHUD();
+      #endif
+
       // Call the step function.
       if (app -> step)
         app -> step();
 
-      // Swap the buffers.
+      // Swap the buffers (satisfying the frame requests so far).
       #ifndef NO_NANITE_RENDER
-        render(app -> window);
+        takeFrameRequests();
+        if (app -> threaded)
+          publishFrame();
+        else
+          render(app -> window);
       #else
         SDL_GL_SwapWindow(app -> window);
       #endif
@@ -1379,9 +9018,14 @@ void setVsync(Application* app) {
   if (!app)
     error("Application is null.");
 
-  // Set the vsync state.
+  // Set the vsync state (on the thread owning the OpenGL context).
   app -> vsync = !(app -> vsync);
-  SDL_GL_SetSwapInterval(app -> vsync ? 1 : 0);
+  int interval = app -> vsync ? 1 : 0;
+  #ifndef NO_NANITE_RENDER
+    renderCall(swapIntervalCall, &interval);
+  #else
+    SDL_GL_SetSwapInterval(interval);
+  #endif
 }
 
 /**
@@ -1411,6 +9055,12 @@ void setFps(Application* app, int fps) {
 
   // Set the fps.
   app -> fps = fps;
+
+  // Hold the new fps with dynamic resolution.
+  #ifndef NO_NANITE_RENDER
+    if (app -> dynamicResolution)
+      setDynamicResolution(true, fps);
+  #endif
 }
 
 /**
@@ -1439,6 +9089,15 @@ void close(Application* app) {
 
   printf("\x1b[5m\x1B[32mClosing\x1B[0m: \"%s\"\n", app -> title);
 
+  // Release the renderer.
+  #ifndef NO_NANITE_RENDER
+    stopRenderThread();
+    finalize();
+  #endif
+
+  // Write the final metrics.
+  stopMetrics();
+
   // Free the window.
   SDL_DestroyWindow(app -> window);
   app -> window = NULL;
@@ -0,0 +1,101 @@
+#define NANITE_IMPLEMENTATION
+#define NO_NANITE_RENDER
+#define NO_NANITE_WINDOW
+#include "nanite.h"
+#include "harness.h"
+
+/**
+ * @brief Feeds a key event to the input state
+ *
+ * @param type SDL_KEYDOWN or SDL_KEYUP
+ * @param scancode The key's scancode
+ */
+static void sendKey(Uint32 type, SDL_Scancode scancode) {
+  SDL_Event event;
+  memset(&event, 0, sizeof(event));
+  event.type = type;
+  event.key.keysym.scancode = scancode;
+  handleInputEvent(&event);
+}
+
+/**
+ * @brief Key and action edge checks
+ */
+int WinMain(void) {
+  initKeystates();
+
+  // Key edges last exactly one frame
+  sendKey(SDL_KEYDOWN, SDL_SCANCODE_S);
+  processInput();
+  check(keyPressed(KEY_S) && keypress(KEY_S) && getKeystate(KEY_S) == KEY_STATE_PRESSED, "key is pressed on the frame it goes down");
+  processInput();
+  check(!keyPressed(KEY_S) && getKeystate(KEY_S) == KEY_STATE_HELD, "key is held after the first frame");
+  sendKey(SDL_KEYUP, SDL_SCANCODE_S);
+  processInput();
+  check(keyReleased(KEY_S) && !keypress(KEY_S), "key is released on the frame it goes up");
+  processInput();
+  check(!keyReleased(KEY_S) && getKeystate(KEY_S) == KEY_STATE_RELEASED, "release lasts one frame");
+
+  // A binding with modifiers needs them held, on either side
+  check(bindAction(3, KEY_S, KEY_MOD_CTRL) && bindAction(3, KEY_F, KEY_MOD_NONE), "keys are bound");
+  check(!bindAction(ACTION_MAX, KEY_S, KEY_MOD_NONE) && !bindAction(0, KEY_MAX, KEY_MOD_NONE), "out of range bindings are refused");
+  sendKey(SDL_KEYDOWN, SDL_SCANCODE_S);
+  processInput();
+  check(!actionHeld(3) && !actionPressed(3), "action waits for its modifier");
+  sendKey(SDL_KEYDOWN, SDL_SCANCODE_RCTRL);
+  processInput();
+  check(actionPressed(3) && actionHeld(3), "action is pressed once the modifier is held");
+  processInput();
+  check(!actionPressed(3) && actionHeld(3), "action press lasts one frame");
+  sendKey(SDL_KEYDOWN, SDL_SCANCODE_F);
+  sendKey(SDL_KEYUP, SDL_SCANCODE_S);
+  processInput();
+  check(actionHeld(3) && !actionPressed(3) && !actionReleased(3), "action stays held while another binding holds it");
+  sendKey(SDL_KEYUP, SDL_SCANCODE_F);
+  processInput();
+  check(actionReleased(3) && !actionHeld(3), "action is released when its last key goes up");
+  sendKey(SDL_KEYUP, SDL_SCANCODE_RCTRL);
+  processInput();
+
+  // Extra modifiers don't stop a binding, and unbinding takes effect on the next frame
+  check(bindAction(5, KEY_SPACE, KEY_MOD_NONE), "second action is bound");
+  sendKey(SDL_KEYDOWN, SDL_SCANCODE_LSHIFT);
+  sendKey(SDL_KEYDOWN, SDL_SCANCODE_SPACE);
+  processInput();
+  check(actionPressed(5) && !actionHeld(3), "action ignores extra modifiers");
+  unbindAction(5);
+  processInput();
+  check(actionReleased(5) && !actionHeld(5), "unbound action is released");
+  sendKey(SDL_KEYUP, SDL_SCANCODE_SPACE);
+  sendKey(SDL_KEYUP, SDL_SCANCODE_LSHIFT);
+  processInput();
+
+  // Resolve random bindings and key states against the bindings themselves
+  unbindAction(3);
+  srand(7);
+  register unsigned int round, action, binding, key;
+  for (round = 0; round < 200; round++) {
+    if (round % 20 == 0) {
+      for (action = 0; action < ACTION_MAX; action++)
+        unbindAction(action);
+      for (binding = 0; binding < 150; binding++)
+        bindAction(rand() % ACTION_MAX, (KEY) (rand() % KEY_MAX), rand() % KEY_MODS);
+    }
+    for (key = 0; key < 6; key++)
+      sendKey(rand() % 2 ? SDL_KEYDOWN : SDL_KEYUP, keyScancodes[rand() % KEY_MAX]);
+    uint64_t before = actionsDown;
+    processInput();
+
+    unsigned int modifiers = (keypress(KEY_LSHIFT) ? KEY_MOD_SHIFT : 0) | (keypress(KEY_LCTRL) ? KEY_MOD_CTRL : 0) | (keypress(KEY_LALT) ? KEY_MOD_ALT : 0);
+    uint64_t expected = 0;
+    for (action = 0; action < ACTION_MAX; action++)
+      for (binding = 0; binding < actions[action].count; binding++)
+        for (key = 0; key < KEY_MAX; key++)
+          if ((actions[action].bindings[binding].modifiers & ~modifiers) == 0 && testKey(actions[action].bindings[binding].keys, keyScancodes[key]) && keypress((KEY) key))
+            expected |= 1ULL << action;
+    check(actionsDown == expected, "actions match their bindings");
+    check(actionsPressed == (expected & ~before) && actionsReleased == (before & ~expected), "action edges match the change");
+  }
+
+  return finishChecks("Action");
+}
\ No newline at end of file
@@ -0,0 +1,118 @@
+#define NANITE_IMPLEMENTATION
+#include "nanite.h"
+#include "harness.h"
+
+#define ENTITIES 1600
+
+static char ids[ENTITIES][16];
+static bool alive[ENTITIES];
+static unsigned char found[ENTITIES][ENTITIES / 8];
+
+/**
+ * @brief Finds the index of an entity from its id
+ *
+ * @param entity The entity
+ * @return The index its id was made at
+ */
+static unsigned int indexOf(const Entity* entity) {
+  return (unsigned int) ((entity -> ID - ids[0]) / sizeof(ids[0]));
+}
+
+/**
+ * @brief Compares the broadphase's pairs with every pair of live entities
+ *
+ * @param message What was checked
+ */
+static void compareOverlaps(const char* message) {
+  unsigned int count, itr, other;
+  const EntityPair* pairs = getOverlaps(&count);
+
+  // Mark every reported pair once, lower index first
+  memset(found, 0, sizeof(found));
+  bool valid = true;
+  for (itr = 0; itr < count; itr++) {
+    unsigned int a = indexOf(pairs[itr].a), b = indexOf(pairs[itr].b);
+    if (a > b) {
+      unsigned int swap = a;
+      a = b;
+      b = swap;
+    }
+    if (a == b || a >= ENTITIES || b >= ENTITIES || !alive[a] || !alive[b] || (found[a][b >> 3] >> (b & 7)) & 1)
+      valid = false;
+    else
+      found[a][b >> 3] |= 1 << (b & 7);
+  }
+
+  // Test every pair of live entities directly
+  unsigned int expected = 0;
+  for (itr = 0; itr < ENTITIES; itr++) {
+    if (!alive[itr])
+      continue;
+    const Entity* a = getEntity(ids[itr]);
+    for (other = itr + 1; other < ENTITIES; other++) {
+      if (!alive[other])
+        continue;
+      const Entity* b = getEntity(ids[other]);
+      bool overlap = a -> position[0] - a -> vertices[0] < b -> position[0] + b -> vertices[0] && b -> position[0] - b -> vertices[0] < a -> position[0] + a -> vertices[0] &&
+        a -> position[1] - a -> vertices[1] < b -> position[1] + b -> vertices[1] && b -> position[1] - b -> vertices[1] < a -> position[1] + a -> vertices[1];
+      expected += overlap;
+      if (overlap != ((found[itr][other >> 3] >> (other & 7)) & 1))
+        valid = false;
+    }
+  }
+  check(valid && count == expected, message);
+}
+
+/**
+ * @brief Moves every live entity a little
+ */
+static void jiggle(void) {
+  register unsigned int itr;
+  for (itr = 0; itr < ENTITIES; itr++) {
+    float delta[3] = { (rand() % 21 - 10) / 1000.0f, (rand() % 21 - 10) / 1000.0f, 0.0f };
+    if (alive[itr])
+      updateEntityPosition(ids[itr], delta);
+  }
+}
+
+/**
+ * @brief Broadphase checks against brute force
+ */
+int WinMain(void) {
+  startHeadless();
+
+  // Scatter entities
+  register unsigned int itr, frame;
+  unsigned int next = 0;
+  srand(1);
+  for (itr = 0; itr < ENTITIES; itr++) {
+    int dimensions[2] = { 1 + rand() % 3, 1 + rand() % 3 };
+    float position[3] = { (rand() % 2000) / 1000.0f - 1.0f, (rand() % 2000) / 1000.0f - 1.0f, 0.0f };
+    alive[itr] = createTestEntity(ids[itr], "entity", &next, dimensions, position);
+    check(alive[itr], "entity is created");
+  }
+  compareOverlaps("overlaps match brute force");
+
+  // Move them, keeping the sort incremental
+  for (frame = 0; frame < 5; frame++) {
+    jiggle();
+    compareOverlaps("overlaps match brute force after moving");
+  }
+
+  // Destroy a third of them
+  for (itr = 0; itr < ENTITIES; itr += 3) {
+    destroyEntity(ids[itr]);
+    alive[itr] = false;
+  }
+  compareOverlaps("overlaps match brute force after destroying");
+
+  // Sweep on several threads
+  setBroadphaseThreads(4);
+  for (frame = 0; frame < 5; frame++) {
+    jiggle();
+    compareOverlaps("threaded overlaps match brute force");
+  }
+  setBroadphaseThreads(0);
+
+  return finishChecks("Broadphase");
+}
\ No newline at end of file
@@ -0,0 +1,63 @@
+#ifndef NANITE_TEST_HARNESS
+#define NANITE_TEST_HARNESS
+
+// Shared by the check programs (include after nanite.h)
+
+static int failures;
+
+/**
+ * @brief Reports a failed check
+ *
+ * @param passed Whether the check passed
+ * @param message What was checked
+ */
+static void check(bool passed, const char* message) {
+  if (!passed) {
+    fprintf(stderr, "Failed: %s\n", message);
+    failures++;
+  }
+}
+
+/**
+ * @brief Reports whether every check passed
+ *
+ * @param name What was checked
+ * @return The program's exit code
+ */
+static int finishChecks(const char* name) {
+  printf("%s checks %s\n", name, failures ? "failed" : "passed");
+  return failures != 0;
+}
+
+#ifdef NANITE_RENDER_IMPLEMENTATION
+
+/**
+ * @brief Creates the render state initialize() would, without a GL context
+ */
+static void startHeadless(void) {
+  entities = createHashMap();
+  shaders = createQueue();
+}
+
+/**
+ * @brief Creates an entity under the next id with a prefix whose slot is free
+ *
+ * createEntity() refuses ids whose slot is taken, so those are passed over.
+ *
+ * @param ID Where to write the id (16 bytes)
+ * @param prefix The id's prefix
+ * @param next The number to try first (advanced past the id used)
+ * @param dimensions The width and height of the entity
+ * @param position The position of the entity
+ * @return true if the entity was created
+ */
+static bool createTestEntity(char* ID, const char* prefix, unsigned int* next, int dimensions[2], float position[3]) {
+  do
+    snprintf(ID, 16, "%s%u", prefix, (*next)++);
+  while (search(entities, ID));
+  return createEntity(ID, dimensions, position);
+}
+
+#endif // NANITE_RENDER_IMPLEMENTATION
+
+#endif // NANITE_TEST_HARNESS
\ No newline at end of file
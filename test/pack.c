@@ -0,0 +1,111 @@
+#include "nanite.h"
+#include "harness.h"
+
+/**
+ * @brief Writes a copy of a pack with a patch applied
+ *
+ * @param filename The copy's filename
+ * @param data The pack's contents
+ * @param size The number of bytes to write (less than the pack to truncate it)
+ * @param offset Where to write the patch
+ * @param patch The bytes to write there (NULL for none)
+ * @param length The number of bytes in the patch
+ */
+static void writeCopy(const char* filename, const unsigned char* data, size_t size, size_t offset, const void* patch, size_t length) {
+  FILE* file = fopen(filename, "wb");
+  fwrite(data, size, 1, file);
+  if (patch) {
+    fseek(file, (long) offset, SEEK_SET);
+    fwrite(patch, length, 1, file);
+  }
+  fclose(file);
+}
+
+/**
+ * @brief Pack build, open and find checks
+ */
+int WinMain(void) {
+  // Write a 3x2 bitmap (24 bits per pixel, rows padded to 12 bytes)
+  static unsigned char rows[24];
+  register unsigned int itr;
+  for (itr = 0; itr < sizeof(rows); itr++)
+    rows[itr] = (unsigned char) itr;
+  BMP image = { { 0x4D42, 54 + sizeof(rows), 0, 54, 40, 3, 2, 1, 24, 0, sizeof(rows), 0, 0, 0, 0 }, rows };
+  check(saveBMP("pack.test.bmp", &image) == 0, "bitmap is written");
+  BMP truncated = image;
+  truncated.header.imagesize = 12;
+  check(!decodeBMP(&truncated), "bitmap with fewer bytes than its rows is refused");
+
+  // Build and open the pack
+  const char* files[] = { "shaders/basic.vert", "shaders/basic.frag", "pack.test.bmp" };
+  check(buildPack("pack.test.pack", files, 3), "pack is built");
+  check(!buildPack("pack.test.missing", (const char*[]) { "shaders/missing.vert" }, 1), "pack refuses a missing file");
+  Pack* pack = openPack("pack.test.pack");
+  check(pack != NULL, "pack opens");
+  if (!pack)
+    return finishChecks("Pack");
+
+  // Find every asset by name and by hash
+  Asset asset;
+  size_t size;
+  char* source = readfile("shaders/basic.vert");
+  check(findAsset(pack, "shaders/basic.vert", &asset) && asset.type == PACK_RAW, "raw asset is found by name");
+  check(source && asset.size == strlen(source) && memcmp(asset.data, source, asset.size) == 0 && ((const char*) asset.data)[asset.size] == '\0', "raw asset matches the file and ends in a NUL");
+  check(findAssetByHash(pack, hashAsset("shaders/basic.frag"), &asset) && strcmp(asset.name, "shaders/basic.frag") == 0, "asset is found by hash");
+  check(findAsset(pack, "pack.test.bmp", &asset) && asset.type == PACK_IMAGE && asset.width == 3 && asset.height == 2 && asset.size == 24, "image is stored decoded");
+  check(asset.size == 24 && memcmp(asset.data, (unsigned char[]) { 2, 1, 0, 255 }, 4) == 0 && memcmp((const unsigned char*) asset.data + 12, (unsigned char[]) { 14, 13, 12, 255 }, 4) == 0, "image rows are swizzled into RGBA");
+  check(!findAsset(pack, "shaders/missing.vert", &asset), "missing asset isn't found");
+  memFree(source);
+
+  // Give the first entry the second one's hash, so finding the second probes past the first
+  unsigned char* data = (unsigned char*) readPackFile("pack.test.pack", &size);
+  PackHeader* header = (PackHeader*) data;
+  PackEntry* entries = (PackEntry*) (data + sizeof(PackHeader));
+  uint32_t* table = (uint32_t*) (entries + header -> count);
+  entries[0].hash = entries[1].hash;
+  memset(table, 0, sizeof(uint32_t) * header -> buckets);
+  for (itr = 0; itr < header -> count; itr++) {
+    uint32_t slot = (uint32_t) entries[itr].hash & (header -> buckets - 1);
+    while (table[slot])
+      slot = (slot + 1) & (header -> buckets - 1);
+    table[slot] = itr + 1;
+  }
+  writeCopy("pack.test.collide", data, size, 0, NULL, 0);
+  Pack* collide = openPack("pack.test.collide");
+  check(collide && findAsset(collide, "shaders/basic.frag", &asset) && strcmp(asset.name, "shaders/basic.frag") == 0, "find probes past a name sharing the hash");
+  check(collide && findAssetByHash(collide, hashAsset("shaders/basic.frag"), &asset) && strcmp(asset.name, "shaders/basic.vert") == 0, "find by hash takes the first entry with the hash");
+  closePack(collide);
+  memFree(data);
+
+  // Refuse packs whose tables, names or data point outside the file
+  data = (unsigned char*) readPackFile("pack.test.pack", &size);
+  header = (PackHeader*) data;
+  entries = (PackEntry*) (data + sizeof(PackHeader));
+  size_t entry = sizeof(PackHeader) + sizeof(PackEntry);
+  uint64_t past = size;
+  uint32_t huge = 0x10000000, odd = 6, name = (uint32_t) size;
+  unsigned char unterminated = 'x';
+  writeCopy("pack.test.corrupt", data, size - 1, 0, NULL, 0);
+  check(!openPack("pack.test.corrupt"), "truncated pack is refused");
+  writeCopy("pack.test.corrupt", data, size, offsetof(PackHeader, count), &huge, sizeof(huge));
+  check(!openPack("pack.test.corrupt"), "pack with too many entries is refused");
+  writeCopy("pack.test.corrupt", data, size, offsetof(PackHeader, buckets), &odd, sizeof(odd));
+  check(!openPack("pack.test.corrupt"), "pack with an uneven table is refused");
+  writeCopy("pack.test.corrupt", data, size, entry + offsetof(PackEntry, offset), &past, sizeof(past));
+  check(!openPack("pack.test.corrupt"), "pack with data past the end is refused");
+  writeCopy("pack.test.corrupt", data, size, entry + offsetof(PackEntry, size), &past, sizeof(past));
+  check(!openPack("pack.test.corrupt"), "pack with oversized data is refused");
+  writeCopy("pack.test.corrupt", data, size, entry + offsetof(PackEntry, name), &name, sizeof(name));
+  check(!openPack("pack.test.corrupt"), "pack with a name past the end is refused");
+  writeCopy("pack.test.corrupt", data, size, entries[0].offset + entries[0].size, &unterminated, sizeof(unterminated));
+  check(entries[0].type == PACK_RAW && !openPack("pack.test.corrupt"), "pack with a raw asset missing its NUL is refused");
+  memFree(data);
+
+  closePack(pack);
+  remove("pack.test.bmp");
+  remove("pack.test.pack");
+  remove("pack.test.collide");
+  remove("pack.test.corrupt");
+
+  return finishChecks("Pack");
+}
\ No newline at end of file
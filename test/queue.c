@@ -0,0 +1,63 @@
+#include "nanite.h"
+#include "harness.h"
+
+/**
+ * @brief Queue and SPSC queue checks
+ */
+int WinMain(void) {
+  static int values[1000];
+  register unsigned int itr, round;
+  for (itr = 0; itr < 1000; itr++)
+    values[itr] = (int) itr;
+
+  // Wrap the ring many times without growing it
+  Queue* queue = createQueue();
+  unsigned int next = 0, expected = 0;
+  for (round = 0; round < 100; round++) {
+    for (itr = 0; itr < 40; itr++)
+      enqueue(queue, &values[next++ % 1000]);
+    for (itr = 0; itr < 40; itr++)
+      check(dequeue(queue) == &values[expected++ % 1000], "queue keeps its order across wraparound");
+  }
+  check(queue -> capacity == QUEUE_CAPACITY, "queue doesn't grow while it has room");
+  check(isEmpty(queue) && dequeue(queue) == NULL, "queue is empty after draining");
+
+  // Grow while wrapped, then check the order, indexing and iteration
+  for (itr = 0; itr < 50; itr++)
+    enqueue(queue, &values[next++ % 1000]);
+  for (itr = 0; itr < 30; itr++)
+    check(dequeue(queue) == &values[expected++ % 1000], "queue keeps its order before growing");
+  for (itr = 0; itr < 500; itr++)
+    enqueue(queue, &values[next++ % 1000]);
+  check(queueSize(queue) == 520, "queue counts its elements after growing");
+  check(queue -> capacity == 1024, "queue grows to a power of two");
+  check(getElement(queue, 0) == &values[expected % 1000] && getElement(queue, 519) == &values[(next - 1) % 1000], "queue indexes from the front");
+  check(getElement(queue, 520) == NULL, "queue rejects an index past the rear");
+  QueueIterator iterator = iterateQueue(queue);
+  void* element;
+  unsigned int seen = 0;
+  while ((element = nextElement(&iterator)))
+    check(element == &values[(expected + seen++) % 1000], "iterator walks front to rear");
+  check(seen == 520 && queueSize(queue) == 520, "iterator leaves the queue alone");
+  while (!isEmpty(queue))
+    check(dequeue(queue) == &values[expected++ % 1000], "queue keeps its order after growing");
+  freeQueue(queue);
+
+  // Wrap the SPSC ring, filling it to the brim each time
+  SPSCQueue* spsc = createSPSCQueue(6);
+  check(spsc -> capacity == 8, "SPSC capacity rounds up to a power of two");
+  next = expected = 0;
+  for (round = 0; round < 100; round++) {
+    for (itr = 0; itr < 8; itr++)
+      check(spscEnqueue(spsc, &values[next++ % 1000]), "SPSC queue accepts up to its capacity");
+    check(!spscEnqueue(spsc, &values[0]), "SPSC queue refuses when full");
+    for (itr = 0; itr < 5; itr++)
+      check(spscDequeue(spsc) == &values[expected++ % 1000], "SPSC queue keeps its order across wraparound");
+    for (itr = 0; itr < 3; itr++)
+      check(spscDequeue(spsc) == &values[expected++ % 1000], "SPSC queue keeps its order across wraparound");
+  }
+  check(spscDequeue(spsc) == NULL, "SPSC queue is empty after draining");
+  freeSPSCQueue(spsc);
+
+  return finishChecks("Queue");
+}
\ No newline at end of file
@@ -0,0 +1,106 @@
+#define NANITE_IMPLEMENTATION
+#include "nanite.h"
+#include "harness.h"
+
+#define ENTITIES 300
+
+static char ids[ENTITIES][16];
+static int parents[ENTITIES];
+static Entity saved[ENTITIES];
+
+/**
+ * @brief Scene save and load checks
+ */
+int WinMain(void) {
+  startHeadless();
+
+  // Make entities, chaining some under earlier ones
+  register unsigned int itr;
+  unsigned int next = 0;
+  srand(5);
+  for (itr = 0; itr < ENTITIES; itr++) {
+    int dimensions[2] = { 1 + rand() % 4, 1 + rand() % 4 };
+    float position[3] = { (rand() % 2000) / 1000.0f - 1.0f, (rand() % 2000) / 1000.0f - 1.0f, (rand() % 10) / 10.0f };
+    check(createTestEntity(ids[itr], "scene", &next, dimensions, position), "entity is created");
+    parents[itr] = itr && rand() % 3 == 0 ? rand() % (int) itr : -1;
+    if (parents[itr] >= 0)
+      check(setEntityParent(ids[itr], ids[parents[itr]]), "entity is attached");
+  }
+  updateTransforms();
+  for (itr = 0; itr < ENTITIES; itr++)
+    saved[itr] = *getEntity(ids[itr]);
+
+  // An id whose slot is taken is refused, leaving the entity holding the slot alone
+  char clash[16];
+  next = 0;
+  do
+    sprintf(clash, "clash%u", next++);
+  while (!search(entities, clash));
+  Entity* holder = (Entity*) search(entities, clash);
+  check(!createEntity(clash, (int[2]) { 1, 1 }, (float[3]) { 0.0f, 0.0f, 0.0f }), "id whose slot is taken is refused");
+  check(!getEntity(clash) && search(entities, clash) == holder, "refused id leaves the slot to its entity");
+
+  // Save the scene, then replace the live entities with the loaded ones
+  check(saveScene("scene.test.bin"), "scene is saved");
+  for (itr = ENTITIES; itr-- > 0;)
+    destroyEntity(ids[itr]);
+  for (itr = 0; itr < MAP_MAX; itr++)
+    check(!entities[itr], "destroyed entities leave the map");
+  Scene* scene = loadScene("scene.test.bin");
+  check(scene != NULL && scene -> count == ENTITIES, "scene loads every entity");
+  if (!scene)
+    return finishChecks("Scene");
+
+  // Every entity comes back with its size, position and parent
+  for (itr = 0; itr < ENTITIES; itr++) {
+    Entity* entity = getEntity(ids[itr]);
+    check(entity && entity -> scene == scene, "loaded entity is registered");
+    if (!entity)
+      continue;
+    check(entity -> width == saved[itr].width && entity -> height == saved[itr].height, "loaded entity keeps its size");
+    check(memcmp(entity -> position, saved[itr].position, sizeof(entity -> position)) == 0, "loaded entity keeps its position");
+    check(memcmp(entity -> local, saved[itr].local, sizeof(entity -> local)) == 0, "loaded entity keeps its local position");
+    check(memcmp(entity -> vertices, saved[itr].vertices, sizeof(entity -> vertices)) == 0, "loaded entity keeps its vertices");
+    check(parents[itr] < 0 ? entity -> parent == NULL : entity -> parent == getEntity(ids[parents[itr]]), "loaded entity keeps its parent");
+  }
+
+  // Loaded hierarchies still move together
+  float delta[3] = { 0.25f, -0.125f, 0.0f };
+  for (itr = 0; itr < ENTITIES && parents[itr] < 0; itr++);
+  if (itr < ENTITIES) {
+    Entity* child = getEntity(ids[itr]);
+    float before[3];
+    memcpy(before, child -> position, sizeof(before));
+    updateEntityPosition(ids[parents[itr]], delta);
+    updateTransforms();
+    check(child -> position[0] == before[0] + delta[0] && child -> position[1] == before[1] + delta[1], "loaded child follows its parent");
+  }
+
+  // Loading the scene again leaves out the ids that are taken
+  Scene* again = loadScene("scene.test.bin");
+  check(again != NULL, "scene loads twice");
+  for (itr = 0; again && itr < again -> count; itr++)
+    check(again -> entities[itr].ID == NULL, "second load leaves out taken ids");
+  unloadScene(again);
+
+  // Unloading destroys the entities that are still alive
+  destroyEntity(ids[0]);
+  unloadScene(scene);
+  for (itr = 0; itr < MAP_MAX; itr++)
+    check(!entities[itr], "unloading clears the map");
+
+  // Refuse missing, foreign and truncated files
+  check(!loadScene("scene.test.missing"), "missing scene is refused");
+  FILE* file = fopen("scene.test.bad", "wb");
+  fwrite("NANISCENxxxx", 12, 1, file);
+  fclose(file);
+  check(!loadScene("scene.test.bad"), "truncated scene is refused");
+  file = fopen("scene.test.bad", "wb");
+  fwrite("NANIPACK", 8, 1, file);
+  fclose(file);
+  check(!loadScene("scene.test.bad"), "foreign file is refused");
+  remove("scene.test.bin");
+  remove("scene.test.bad");
+
+  return finishChecks("Scene");
+}
\ No newline at end of file
@@ -0,0 +1,142 @@
+#define NANITE_IMPLEMENTATION
+#include "nanite.h"
+#include "harness.h"
+
+#define ENTITIES 400
+
+static char ids[ENTITIES][16];
+static int parents[ENTITIES];
+static float locals[ENTITIES][3];
+
+/**
+ * @brief Finds where an entity should be by walking up the reference hierarchy
+ *
+ * @param index The entity's index
+ * @param world Where to write its world position
+ */
+static void expectedPosition(int index, float world[3]) {
+  world[0] = world[1] = world[2] = 0.0f;
+  for (; index >= 0; index = parents[index]) {
+    world[0] += locals[index][0];
+    world[1] += locals[index][1];
+    world[2] += locals[index][2];
+  }
+}
+
+/**
+ * @brief Compares every entity's position and parent with the reference hierarchy
+ *
+ * @param message What was checked
+ */
+static void compareTransforms(const char* message) {
+  register unsigned int itr;
+  bool valid = true;
+  updateTransforms();
+  for (itr = 0; itr < ENTITIES; itr++) {
+    Entity* entity = getEntity(ids[itr]);
+    float world[3];
+    expectedPosition((int) itr, world);
+    if (!entity || memcmp(entity -> position, world, sizeof(world)) != 0)
+      valid = false;
+    else if (parents[itr] < 0 ? entity -> parent != NULL : entity -> parent != getEntity(ids[parents[itr]]))
+      valid = false;
+  }
+
+  // Parents come before their children once sorted
+  for (itr = 1; itr < transformCount; itr++)
+    if (transforms[itr - 1] -> depth > transforms[itr] -> depth || transforms[itr] -> node != itr + 1)
+      valid = false;
+  check(valid, message);
+}
+
+/**
+ * @brief Transform hierarchy checks against a reference hierarchy
+ */
+int WinMain(void) {
+  startHeadless();
+
+  // Make entities, all at the origin
+  register unsigned int itr, step;
+  unsigned int next = 0;
+  for (itr = 0; itr < ENTITIES; itr++) {
+    int dimensions[2] = { 2, 2 };
+    float position[3] = { 0.0f, 0.0f, 0.0f };
+    check(createTestEntity(ids[itr], "node", &next, dimensions, position), "entity is created");
+    parents[itr] = -1;
+  }
+
+  // Move and reparent at random (in quarter steps, so every sum is exact)
+  srand(3);
+  for (step = 0; step < 5000; step++) {
+    int index = rand() % ENTITIES, action = rand() % 10;
+    if (action < 6) {
+      float delta[3] = { (rand() % 9 - 4) / 4.0f, (rand() % 9 - 4) / 4.0f, (rand() % 3) / 4.0f };
+      updateEntityPosition(ids[index], delta);
+      locals[index][0] += delta[0];
+      locals[index][1] += delta[1];
+      locals[index][2] += delta[2];
+    } else if (action < 9) {
+      int parent = rand() % 4 == 0 ? -1 : rand() % ENTITIES, ancestor;
+      bool cycle = false;
+      for (ancestor = parent; ancestor >= 0; ancestor = parents[ancestor])
+        cycle |= ancestor == index;
+      bool attached = setEntityParent(ids[index], parent < 0 ? NULL : ids[parent]);
+      check(attached == !cycle, "attaching below itself is refused, and nothing else is");
+      if (attached) {
+        // Keep the world position, as setEntityParent() does
+        float world[3], origin[3] = { 0.0f, 0.0f, 0.0f };
+        expectedPosition(index, world);
+        if (parent >= 0)
+          expectedPosition(parent, origin);
+        parents[index] = parent;
+        locals[index][0] = world[0] - origin[0];
+        locals[index][1] = world[1] - origin[1];
+        locals[index][2] = world[2] - origin[2];
+      }
+    } else
+      compareTransforms("positions follow their parents");
+  }
+  compareTransforms("positions follow their parents");
+
+  // Reading a child's position brings it up to date with a moved parent
+  for (itr = 0; itr < ENTITIES && parents[itr] < 0; itr++);
+  if (itr < ENTITIES) {
+    float delta[3] = { 1.0f, 1.0f, 1.0f }, world[3];
+    int parent = parents[itr];
+    updateEntityPosition(ids[parent], delta);
+    locals[parent][0] += 1.0f;
+    locals[parent][1] += 1.0f;
+    locals[parent][2] += 1.0f;
+    check(getEntityPosition(ids[itr]) != NULL, "child's position is read");
+    expectedPosition((int) itr, world);
+    check(memcmp(getEntity(ids[itr]) -> position, world, sizeof(world)) == 0, "reading a position applies its parent's move");
+  }
+
+  // Destroying a parent leaves its children where they are, detached
+  for (itr = 0; itr < ENTITIES && !getEntity(ids[itr]) -> children; itr++);
+  if (itr < ENTITIES) {
+    unsigned int child;
+    for (child = 0; child < ENTITIES; child++) {
+      if (parents[child] != (int) itr)
+        continue;
+      float world[3];
+      expectedPosition((int) child, world);
+      memcpy(locals[child], world, sizeof(world));
+      parents[child] = -1;
+    }
+    destroyEntity(ids[itr]);
+    parents[itr] = -1;
+    memset(locals[itr], 0, sizeof(locals[itr]));
+    float position[3] = { 0.0f, 0.0f, 0.0f };
+    int dimensions[2] = { 2, 2 };
+    check(createEntity(ids[itr], dimensions, position), "destroyed entity's id is free again");
+    compareTransforms("children keep their place when their parent is destroyed");
+  }
+
+  // Destroying everything empties the hierarchy
+  for (itr = 0; itr < ENTITIES; itr++)
+    destroyEntity(ids[itr]);
+  check(transformCount == 0, "destroyed entities leave the hierarchy");
+
+  return finishChecks("Transform");
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#include "../nanite.h"
+
+/**
+ * @brief Packs assets into a single archive
+ *
+ * Usage: pack <output> <file>...
+ * Asset names are the paths as given, so pack from the directory the
+ * application runs in (e.g. "pack assets.pack shaders/basic.vert").
+ */
+int main(int argc, char** argv) {
+  // Verify the arguments
+  if (argc < 2) {
+    fprintf(stderr, "Usage: %s <output> <file>...\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // Build the pack
+  if (!buildPack(argv[1], (const char**) (argv + 2), (unsigned int) (argc - 2)))
+    return EXIT_FAILURE;
+
+  printf("\x1b[5m\x1B[32mPacked\x1B[0m: \"%s\" (%d assets)\n", argv[1], argc - 2);
+  return EXIT_SUCCESS;
+}